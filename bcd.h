@@ -0,0 +1,75 @@
+#ifndef bcd_h
+#define bcd_h
+
+// Двоично-десятичные (BCD) регистры DS3231: кодирование и разбор чтением
+// из таблиц, построенных при компиляции, без деления на 10.
+// Таблица разбора покрывает все 256 значений байта; в байте с неверной
+// тетрадой (больше 9) получается BCD_INVALID. Биты, не относящиеся к числу
+// (век в регистре месяца, режим 12/24 в регистре часов), снимает вызывающий.
+
+#include <stdint.h>
+
+#define BCD_INVALID 0xFF
+
+// Регистр часов: 12-часовой режим и признак PM (в 24-часовом — десяток 20)
+#define BCD_HOURS_12 0x40
+#define BCD_HOURS_PM 0x20
+
+struct BcdTables {
+    uint8_t encode[100];
+    uint8_t decode[256];
+
+    constexpr BcdTables() : encode(), decode() {
+        for (uint16_t b = 0; b < 256; b++) {
+            decode[b] = (b >> 4) < 10 && (b & 0xF) < 10 ? (b >> 4) * 10 + (b & 0xF) : BCD_INVALID;
+        }
+        for (uint8_t v = 0; v < 100; v++) encode[v] = (v / 10) << 4 | v % 10;
+    }
+};
+
+constexpr BcdTables bcdTables{};
+
+constexpr uint8_t bcdEncode(uint8_t v) {
+    return bcdTables.encode[v < 100 ? v : 99];
+}
+
+constexpr uint8_t bcdDecode(uint8_t b) {
+    return bcdTables.decode[b];
+}
+
+// Часы 1..12 с признаком PM в 24-часовом виде. Проверка до приведения:
+// BCD_INVALID % 12 дало бы правдоподобный час
+constexpr uint8_t bcdHours12(uint8_t h, bool pm) {
+    return h == 0 || h > 12 ? BCD_INVALID : h % 12 + (pm ? 12 : 0);
+}
+
+// Часы в 24-часовом виде из регистра 0x02 в любом из двух режимов;
+// BCD_INVALID — неверная тетрада или час вне диапазона режима
+constexpr uint8_t bcdDecodeHours(uint8_t b) {
+    return (b & BCD_HOURS_12)
+        ? bcdHours12(bcdDecode(b & 0x1F), b & BCD_HOURS_PM)
+        : (bcdDecode(b & 0x3F) < 24 ? bcdDecode(b & 0x3F) : BCD_INVALID);
+}
+
+// Таблицы проверяются целиком при компиляции
+constexpr bool bcdTablesValid() {
+    uint16_t valid = 0;
+    for (uint16_t b = 0; b < 256; b++) {
+        if (bcdDecode(b) == BCD_INVALID) continue;
+        if (bcdEncode(bcdDecode(b)) != b) return false;
+        valid++;
+    }
+    for (uint8_t v = 0; v < 100; v++) {
+        if (bcdDecode(bcdEncode(v)) != v) return false;
+    }
+    return valid == 100;
+}
+
+static_assert(bcdTablesValid(), "BCD tables must be a bijection between 0..99 and valid BCD bytes");
+static_assert(bcdDecodeHours(0x23) == 23 && bcdDecodeHours(0x52) == 0 && bcdDecodeHours(0x72) == 12 &&
+              bcdDecodeHours(0x61) == 13, "24h and 12h hour registers");
+static_assert(bcdDecodeHours(0x4A) == BCD_INVALID && bcdDecodeHours(0x6F) == BCD_INVALID &&
+              bcdDecodeHours(0x40) == BCD_INVALID && bcdDecodeHours(0x24) == BCD_INVALID,
+              "Invalid hour registers must stay invalid in both modes");
+
+#endif
@@ -0,0 +1,74 @@
+#include "ble.h"
+
+#include <string.h>
+
+#include "config.h"
+#include "hal.h"
+#include "uart.h"
+
+static uint32_t baud = BLE_BAUD_FALLBACK;
+
+// Код скорости для AT+BAUDn
+static char baudCode(uint32_t rate) {
+    switch (rate) {
+        case 19200: return '1';
+        case 38400: return '2';
+        case 57600: return '3';
+        case 115200: return '4';
+        default: return '0';
+    }
+}
+
+// Команда модулю и ожидание ответа, начинающегося с reply
+static bool command(const char *cmd, const char *reply) {
+    while (halUartRead() >= 0) {}           // Остатки прежних ответов
+
+    uartWriteAll((const uint8_t *)cmd, strlen(cmd));
+    uartFlush();
+
+    size_t want = strlen(reply), got = 0;
+    char buf[16];
+    uint32_t start = halMillis();
+    while (halMillis() - start < BLE_AT_TIMEOUT_MS) {
+        int c = halUartRead();
+        if (c < 0) {
+            halSleepUs(1000);
+            continue;
+        }
+        // Ответы HM-10 без перевода строки: хвост прежнего ответа может прийти
+        // уже после очистки, поэтому ответ ищется в конце принятого
+        if (got == sizeof(buf)) memmove(buf, buf + 1, --got);
+        buf[got++] = (char)c;
+        if (got >= want && memcmp(buf + got - want, reply, want) == 0) return true;
+    }
+    return false;
+}
+
+static bool probe(uint32_t rate) {
+    uartBegin(rate);
+    baud = rate;
+    return command("AT", "OK");
+}
+
+BleResult bleBegin() {
+    halUartAttachRx(nullptr);               // Ответы модуля читаются здесь, а не разборщиком кадров
+    if (probe(BLE_BAUD)) return BLE_FAST;
+    if (!probe(BLE_BAUD_FALLBACK)) return BLE_SILENT;
+
+    char cmd[] = "AT+BAUD0";
+    cmd[7] = baudCode(BLE_BAUD);
+    if (command(cmd, "OK+Set") && command("AT+RESET", "OK+RESET")) {
+        halDelayMs(BLE_RESET_MS);
+        if (probe(BLE_BAUD)) return BLE_SWITCHED;
+        // Модуль перезапустился на прежней скорости
+        if (probe(BLE_BAUD_FALLBACK)) return BLE_REJECTED;
+        uartBegin(BLE_BAUD_FALLBACK);
+        baud = BLE_BAUD_FALLBACK;
+        return BLE_SILENT;
+    }
+    return BLE_REJECTED;
+}
+
+uint32_t bleBaud() {
+    return baud;
+}
@@ -0,0 +1,27 @@
+#ifndef ble_h
+#define ble_h
+
+// Скорость UART модуля BLE HM-10.
+// Модуль по умолчанию работает на 9600 бод, и ответ на 0x09 или выгрузку
+// расписания стоит около 1 мс на байт. При запуске, пока соединения нет и
+// модуль понимает AT-команды, скорость поднимается до BLE_BAUD:
+//   1. «AT» на BLE_BAUD — модуль уже переведён раньше (настройка хранится в нём);
+//   2. «AT» на BLE_BAUD_FALLBACK, затем AT+BAUDn, AT+RESET и снова «AT» на BLE_BAUD;
+//   3. если модуль не ответил или не перешёл — остаётся BLE_BAUD_FALLBACK.
+// HM-10 не завершает команды переводом строки: конец команды — пауза,
+// поэтому каждая команда передаётся целиком и ждёт ответа.
+
+#include <stdint.h>
+
+// Итог согласования
+enum BleResult : uint8_t {
+    BLE_FAST,               // Модуль уже работал на BLE_BAUD
+    BLE_SWITCHED,           // Модуль переведён на BLE_BAUD
+    BLE_REJECTED,           // Модуль ответил, но на BLE_BAUD не перешёл
+    BLE_SILENT              // Модуль не ответил (соединение есть или модуля нет)
+};
+
+BleResult bleBegin();       // Вызывать до framerBegin(): ответы модуля читаются из буфера ядра
+uint32_t bleBaud();
+
+#endif
@@ -0,0 +1,134 @@
+#include "bus.h"
+
+#include <string.h>
+
+#include "hal.h"
+#include "prof.h"
+
+// Задание очереди
+struct Job {
+    uint8_t dev;            // Адрес устройства
+    uint8_t len;            // Байты для записи (для чтения — адрес регистра)
+    uint8_t readLen;        // 0 — задание записи
+    bool waitReady;         // Дождаться подтверждения адреса
+    bool started;           // Ожидание готовности началось
+    uint8_t id;
+    uint32_t startUs;       // Начало ожидания готовности
+    BusCallback cb;
+    uint8_t data[BUS_DATA];
+};
+
+// Очередь заданий: и ставит, и выполняет loop(), прерывания её не трогают
+static Job queue[BUS_QUEUE];
+static uint8_t qHead = 0;
+static uint8_t qCount = 0;
+static uint8_t nextId = 0;
+static BusStats stats;
+
+// Новое задание в конце очереди; nullptr — очередь заполнена
+static Job *post(uint8_t dev, bool waitReady, BusCallback cb) {
+    if (qCount == BUS_QUEUE) {
+        stats.rejected++;
+        return nullptr;
+    }
+
+    Job &job = queue[(qHead + qCount) % BUS_QUEUE];
+    qCount++;
+    if (qCount > stats.maxQueued) stats.maxQueued = qCount;
+
+    job.dev = dev;
+    job.waitReady = waitReady;
+    job.started = false;
+    job.id = nextId;
+    nextId = nextId + 1 == BUS_FULL ? 0 : nextId + 1;
+    job.cb = cb;
+    return &job;
+}
+
+// Задание снимается с очереди до вызова обработчика: он может ставить новые
+static void finish(bool ok, uint8_t n) {
+    Job done = queue[qHead];
+    qHead = (qHead + 1) % BUS_QUEUE;
+    qCount--;
+
+    stats.jobs++;
+    if (!ok) stats.failures++;
+    if (done.cb) done.cb(done.id, ok, done.data, n);
+}
+
+uint8_t busWrite(uint8_t dev, const uint8_t *data, uint8_t len, bool waitReady, BusCallback cb) {
+    if (len > BUS_DATA) len = BUS_DATA;
+    Job *job = post(dev, waitReady, cb);
+    if (!job) return BUS_FULL;
+    job->len = len;
+    job->readLen = 0;
+    memcpy(job->data, data, len);
+    return job->id;
+}
+
+uint8_t busRead(uint8_t dev, const uint8_t *reg, uint8_t regLen, uint8_t len, bool waitReady,
+                BusCallback cb) {
+    if (regLen > BUS_DATA) regLen = BUS_DATA;
+    if (len > BUS_DATA) len = BUS_DATA;
+    Job *job = post(dev, waitReady, cb);
+    if (!job) return BUS_FULL;
+    job->len = regLen;
+    job->readLen = len;
+    memcpy(job->data, reg, regLen);
+    return job->id;
+}
+
+void busPoll() {
+    if (qCount == 0) return;
+    PROF_SCOPE(PROF_BUS_POLL);
+    Job &job = queue[qHead];
+
+    if (job.waitReady) {
+        if (!job.started) {
+            job.started = true;
+            job.startUs = halMicros();
+        }
+        if (halI2cWrite(job.dev, nullptr, 0) != 0) {
+            if (halMicros() - job.startUs > BUS_READY_TIMEOUT_US) {
+                finish(false, 0);
+                return;
+            }
+            stats.polls++;
+            return;                 // Устройство занято: проверим на следующем проходе
+        }
+    }
+
+    if (job.readLen == 0) {
+        finish(halI2cWrite(job.dev, job.data, job.len) == 0, 0);
+        return;
+    }
+
+    if (halI2cWrite(job.dev, job.data, job.len, false) != 0) {
+        finish(false, 0);
+        return;
+    }
+    size_t n = halI2cRead(job.dev, job.data, job.readLen);
+    finish(n == job.readLen, (uint8_t)n);
+}
+
+bool busFlush() {
+    uint32_t failures = stats.failures;
+    while (qCount > 0) busPoll();
+    return stats.failures == failures;
+}
+
+bool busIdle() {
+    return qCount == 0;
+}
+
+uint8_t busFree() {
+    return BUS_QUEUE - qCount;
+}
+
+bool busWaiting() {
+    return qCount > 0 && queue[qHead].waitReady && queue[qHead].started;
+}
+
+const BusStats &busStats() {
+    return stats;
+}
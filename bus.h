@@ -0,0 +1,54 @@
+#ifndef bus_h
+#define bus_h
+
+// Кооперативная очередь транзакций I2C.
+// Запись и чтение ставятся в очередь заданиями, а busPoll() из loop()
+// продвигает не больше одного задания за проход: одна транзакция на шине
+// или одна проверка готовности устройства. Ожидание цикла записи EEPROM
+// растягивается на несколько проходов loop(), поэтому разбор кадров и
+// управление двигателем идут между страницами записи.
+// Задания выполняются строго по порядку постановки.
+// Постановка в заполненную очередь не ждёт: задание не ставится, и вызывающий
+// повторяет его позже или сначала сам освобождает очередь.
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "config.h"
+
+#define BUS_QUEUE 8                 // Максимальное количество заданий в очереди
+#define BUS_DATA (2 + EEPROM_PAGE)  // Адрес в EEPROM и одна страница данных
+#define BUS_READY_TIMEOUT_US 10000  // Сколько ждать подтверждения адреса
+#define BUS_FULL 0xFF               // Задание не поставлено: очередь заполнена
+
+// Задание выполнено. ok — транзакция подтверждена устройством,
+// data и len — прочитанные байты (для записи len = 0)
+typedef void (*BusCallback)(uint8_t id, bool ok, const uint8_t *data, uint8_t len);
+
+// Счётчики очереди
+struct BusStats {
+    uint32_t jobs;          // Выполненные задания
+    uint32_t failures;      // Задания, завершённые с ошибкой
+    uint32_t polls;         // Проверки готовности, на которые устройство не ответило
+    uint32_t rejected;      // Задания, не поставленные: очередь заполнена
+    uint8_t maxQueued;      // Наибольшая длина очереди
+};
+
+// Запись len байт устройству dev. waitReady — перед записью дождаться,
+// пока устройство подтвердит адрес (окончание цикла записи EEPROM).
+// Возвращает номер задания или BUS_FULL
+uint8_t busWrite(uint8_t dev, const uint8_t *data, uint8_t len, bool waitReady = false,
+                 BusCallback cb = nullptr);
+
+// Запись адреса регистра reg (regLen байт) без STOP и чтение len байт
+uint8_t busRead(uint8_t dev, const uint8_t *reg, uint8_t regLen, uint8_t len, bool waitReady,
+                BusCallback cb);
+
+void busPoll();                 // Один шаг очереди, вызывать из loop()
+bool busFlush();                // Выполнить всё поставленное; false — были ошибки
+bool busIdle();
+uint8_t busFree();               // Свободных мест в очереди
+bool busWaiting();              // Первое задание ждёт окончания цикла записи устройства
+const BusStats &busStats();
+
+#endif
@@ -0,0 +1,105 @@
+#ifndef calendar_h
+#define calendar_h
+
+// Григорианский календарь, все функции constexpr и без циклов.
+// Дни и секунды считаются от 2000-01-01 00:00:00 — от начала века DS3231.
+// Перевод даты в номер дня и обратно — алгоритмы days_from_civil и
+// civil_from_days (H. Hinnant): год считается с 1 марта, поэтому 29 февраля
+// оказывается последним днём года, и длина месяцев не зависит от
+// високосности. Правило високосных лет полное (1900 и 2100 — не високосные),
+// поэтому функции верны и за пределами 2000..2099, которые хранит DS3231.
+
+#include <stdint.h>
+
+#define CALENDAR_DAYS_0000_03_01 730425L    // От 0000-03-01 до 2000-01-01
+#define CALENDAR_DAYS_PER_ERA 146097L       // 400 лет
+
+struct CivilDate {
+    int16_t year;
+    uint8_t month;          // 1..12
+    uint8_t day;            // 1..31
+};
+
+constexpr bool isLeapYear(int32_t y) {
+    return y % 4 == 0 && (y % 100 != 0 || y % 400 == 0);
+}
+
+constexpr uint8_t daysInMonth(int32_t y, uint8_t m) {
+    return m == 2 ? (isLeapYear(y) ? 29 : 28) : (m == 4 || m == 6 || m == 9 || m == 11) ? 30 : 31;
+}
+
+// Номер дня от 2000-01-01, дни раньше — отрицательные
+constexpr int32_t daysFromCivil(int32_t y, uint8_t m, uint8_t d) {
+    y -= m <= 2;
+    int32_t era = (y >= 0 ? y : y - 399) / 400;
+    int32_t yoe = y - era * 400;                                        // 0..399
+    int32_t doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;      // 0..365, от 1 марта
+    int32_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;                // 0..146096
+    return era * CALENDAR_DAYS_PER_ERA + doe - CALENDAR_DAYS_0000_03_01;
+}
+
+constexpr CivilDate civilFromDays(int32_t days) {
+    int32_t z = days + CALENDAR_DAYS_0000_03_01;
+    int32_t era = (z >= 0 ? z : z - (CALENDAR_DAYS_PER_ERA - 1)) / CALENDAR_DAYS_PER_ERA;
+    int32_t doe = z - era * CALENDAR_DAYS_PER_ERA;
+    int32_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    int32_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    int32_t mp = (5 * doy + 2) / 153;                                   // 0 — март
+    uint8_t m = mp < 10 ? mp + 3 : mp - 9;
+    return CivilDate{(int16_t)(yoe + era * 400 + (m <= 2)), m, (uint8_t)(doy - (153 * mp + 2) / 5 + 1)};
+}
+
+// День недели как в регистре DS3231: 1 — понедельник, 7 — воскресенье.
+// 2000-01-01 — суббота
+constexpr uint8_t weekdayFromDays(int32_t days) {
+    return (uint8_t)((days % 7 + 12) % 7 + 1);
+}
+
+// Секунды от 2000-01-01 00:00:00; в uint32_t помещаются годы до 2136
+constexpr uint32_t epochFromCivil(int32_t y, uint8_t m, uint8_t d, uint8_t hours, uint8_t minutes, uint8_t seconds) {
+    return (uint32_t)daysFromCivil(y, m, d) * 86400UL + hours * 3600UL + minutes * 60UL + seconds;
+}
+
+// Секунда и минута недели, 0 — понедельник 00:00
+constexpr uint32_t secondOfWeek(uint32_t epoch) {
+    return (weekdayFromDays((int32_t)(epoch / 86400UL)) - 1) * 86400UL + epoch % 86400UL;
+}
+
+constexpr uint16_t minuteOfWeek(uint32_t epoch) {
+    return (uint16_t)(secondOfWeek(epoch) / 60);
+}
+
+// Время сборки из __DATE__ ("Mmm dd yyyy", день с пробелом вместо нуля)
+// и __TIME__ ("hh:mm:ss"), разбирается при компиляции
+constexpr uint8_t calendarDigit(char c) {
+    return c >= '0' && c <= '9' ? c - '0' : 0;
+}
+
+constexpr uint8_t calendarMonth(const char *date) {
+    const char *names = "JanFebMarAprMayJunJulAugSepOctNovDec";
+    for (uint8_t m = 0; m < 12; m++) {
+        if (names[3 * m] == date[0] && names[3 * m + 1] == date[1] && names[3 * m + 2] == date[2]) return m + 1;
+    }
+    return 0;
+}
+
+constexpr uint32_t calendarBuildEpoch(const char *date, const char *time) {
+    return epochFromCivil(calendarDigit(date[7]) * 1000 + calendarDigit(date[8]) * 100 +
+                              calendarDigit(date[9]) * 10 + calendarDigit(date[10]),
+                          calendarMonth(date), calendarDigit(date[4]) * 10 + calendarDigit(date[5]),
+                          calendarDigit(time[0]) * 10 + calendarDigit(time[1]),
+                          calendarDigit(time[3]) * 10 + calendarDigit(time[4]),
+                          calendarDigit(time[6]) * 10 + calendarDigit(time[7]));
+}
+
+// Самопроверка на известных датах
+static_assert(daysFromCivil(2000, 1, 1) == 0, "Calendar epoch must be 2000-01-01");
+static_assert(daysFromCivil(2000, 3, 1) == 60 && daysFromCivil(2100, 3, 1) - daysFromCivil(2100, 2, 28) == 1,
+              "2000 is a leap year, 2100 is not");
+static_assert(weekdayFromDays(0) == 6 && weekdayFromDays(daysFromCivil(2024, 1, 1)) == 1,
+              "2000-01-01 is Saturday, 2024-01-01 is Monday");
+static_assert(civilFromDays(daysFromCivil(2099, 12, 31)).day == 31, "Round trip at the end of the DS3231 range");
+static_assert(calendarBuildEpoch("Feb 29 2024", "12:34:56") == epochFromCivil(2024, 2, 29, 12, 34, 56),
+              "__DATE__/__TIME__ parsing");
+
+#endif
@@ -4,11 +4,68 @@
 
 #define SOUND 6             // Пин для управления звуковым сигналом
 
-#define MAX_TASK 6          // Максимальное количество задач (будильников)
-#define MAX_PAYLOAD_SIZE 8  // Максимальный размер пакета данных с блютуз в байтах
+#define MAX_TASK 256        // Максимальное количество задач (будильников), не больше 256
+#define MAX_PAYLOAD_SIZE 128 // Максимальный размер пакета данных с блютуз в байтах (загрузка расписания)
+#define SHORT_PAYLOAD_SIZE 8 // Максимальный размер данных остальных команд
+#define FRAME_LEGACY 1      // Принимать пакеты без обрамления от приложения Cat.aia (framer.h)
 
-#define SPEED 200           // Скорость движения шагового двигателя
+#define BLE_BAUD 115200     // Скорость UART модуля BLE (HM-10), если он принимает AT+BAUD
+#define BLE_BAUD_FALLBACK 9600      // Скорость по умолчанию HM-10: модуль не ответил или не перешёл
+#define BLE_AT_TIMEOUT_MS 100       // Ожидание ответа на AT-команду, мс
+#define BLE_RESET_MS 700            // Перезапуск модуля после AT+RESET, мс
+#define BLE_SESSION_GAP_MS 60000UL  // Команда после такой паузы — новое подключение приложения (сигнал)
+#define UART_TX_SIZE 512    // Очередь передачи UART, байт (степень двойки)
+#define UART_TX_REFILL 8    // Подкачка FIFO передатчика (16 байт) каждые столько байт линии
+
+#define I2C_CLOCK_HZ 400000     // Частота шины I2C: DS3231 и 24C32 работают на 400 кГц
+#define RTC_INT -1          // Пин, к которому подключён INT/SQW часов DS3231 (-1 — не подключён)
+#define CLOCK_SYNC_MS 600000UL      // Интервал сверки программных часов с DS3231, мс
+#define SCHED_MAX_SLEEP_MS 3600000UL // Наибольший интервал между проверками расписания, мс
+#define SCHED_HOLD_S 600UL          // Перевод часов назад до 10 минут не повторяет кормления, с
+#define IDLE_BUS_POLL_US 500        // Сон между проверками готовности EEPROM, мкс
+
+#define CPU_HZ 80000000UL   // Частота ядра (f_cpu в CMakeLists.txt)
+#ifndef PROFILE
+#define PROFILE 1           // Профилирование участков кода по счётчику тактов (prof.h)
+#endif
+
+#ifndef LOG_LEVEL
+#define LOG_LEVEL 3         // Уровень журнала: 0 — нет, 1 — ошибки, 2 — предупреждения, 3 — события, 4 — отладка
+#endif
+#define LOG_BUFFER 256      // Буфер журнала в RAM, байт (степень двойки)
+#define LOG_DRAIN_BYTES 16  // Байт журнала за проход loop(): FIFO передатчика UART платы
+
+#define SPEED 100           // Полупериод STEP на полной скорости, мкс
+#define MOTION_PROFILE RAMP_S_CURVE // Форма разгона и торможения: RAMP_TRAPEZOID или RAMP_S_CURVE (ramp.h)
+#define MOTION_START_HZ 2500        // Частота шагов в начале разгона и в конце торможения
+#define MOTION_ACCEL 25000          // Среднее ускорение разгона, шагов/с^2
+#define MOTION_DECEL 25000          // Среднее замедление торможения, шагов/с^2
 #define PARTITION 800       // Количество шагов одной порции
+#ifndef MOTION_CHANNELS
+#define MOTION_CHANNELS 1   // Двигатели на одном таймере (каналы), не больше 8 и строк MOTION_CHANNEL_TABLE
+#endif
+#define MOTION_MERGE_US 8   // Фронты каналов ближе этого выдаются в одном прерывании, мкс
+// Каналы {EN, DIR, STEP, полупериод на полной скорости, шагов на порцию},
+// используются первые MOTION_CHANNELS строк. Выводы каналов 1..3 — пример
+#define MOTION_CHANNEL_TABLE { \
+    {EN, DIR, STEP, SPEED, PARTITION},          /* 0 — шнек */ \
+    {14, 12, 10, 2 * SPEED, PARTITION / 4},     /* 1 — мешалка */ \
+    {9, 8, 7, SPEED, PARTITION},                /* 2 — шнек второй миски */ \
+    {5, 4, 3, SPEED, PARTITION},                /* 3 — шнек третьей миски */ \
+}
 
 #define EEPROM_ADDR 0x57            // Адрес устройства EEPROM на шине I2C, НЕ МЕНЯТЬ!
 #define EEPROM_START_ADDR 0x0000    // Начальный адрес для записи/чтения в EEPROM, НЕ МЕНЯТЬ!
+#define EEPROM_SIZE 4096            // Объём EEPROM (24C32), байт
+#define EEPROM_PAGE 32              // Размер страницы EEPROM, байт
+
+// Разметка EEPROM: две копии образа задач и журнал изменений
+#define STORE_IMAGE_SIZE 0x0420                             // Размер одной копии образа
+#define STORE_IMAGE_A EEPROM_START_ADDR
+#define STORE_IMAGE_B (EEPROM_START_ADDR + STORE_IMAGE_SIZE)
+#define STORE_JOURNAL_ADDR (EEPROM_START_ADDR + 2 * STORE_IMAGE_SIZE)
+#define STORE_JOURNAL_SIZE 0x03C0
+
+// История кормлений (history.h): кольцо страниц до конца EEPROM
+#define HISTORY_ADDR (STORE_JOURNAL_ADDR + STORE_JOURNAL_SIZE)
+#define HISTORY_SIZE (EEPROM_SIZE - HISTORY_ADDR)
@@ -0,0 +1,19 @@
+#include "crc.h"
+
+// Таблица CRC-8 (полином 0x07), строится при компиляции
+struct Crc8Table {
+    uint8_t v[256];
+    constexpr Crc8Table() : v() {
+        for (int i = 0; i < 256; i++) {
+            uint8_t c = i;
+            for (int b = 0; b < 8; b++) c = (c & 0x80) ? (uint8_t)((c << 1) ^ 0x07) : (uint8_t)(c << 1);
+            v[i] = c;
+        }
+    }
+};
+static constexpr Crc8Table crcTable;
+
+uint8_t crc8(const uint8_t *data, size_t len, uint8_t crc) {
+    while (len--) crc = crcTable.v[crc ^ *data++];
+    return crc;
+}
@@ -0,0 +1,10 @@
+#ifndef crc_h
+#define crc_h
+
+#include <stdint.h>
+#include <stddef.h>
+
+// CRC-8, полином 0x07: кадры Serial1 и записи в EEPROM
+uint8_t crc8(const uint8_t *data, size_t len, uint8_t crc = 0);
+
+#endif
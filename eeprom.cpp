@@ -0,0 +1,79 @@
+#include "eeprom.h"
+
+#include <string.h>
+
+#include "config.h"
+#include "hal.h"
+
+#define EEPROM_POLL_US 10000    // Цикл записи по документации — не более 5 мс
+
+bool eepromWaitReady() {
+    uint32_t start = halMicros();
+    while (halI2cWrite(EEPROM_ADDR, nullptr, 0) != 0) {
+        if (halMicros() - start > EEPROM_POLL_US) return false;
+    }
+    return true;
+}
+
+bool eepromWriteAsync(uint16_t addr, const uint8_t *data, size_t len, BusCallback cb) {
+    uint8_t frame[2 + EEPROM_PAGE];                 // Адрес в EEPROM + одна страница данных
+
+    size_t pages = (addr % EEPROM_PAGE + len + EEPROM_PAGE - 1) / EEPROM_PAGE;
+    if (pages > busFree()) return false;
+
+    while (len > 0) {
+        size_t pageLeft = EEPROM_PAGE - (addr % EEPROM_PAGE);
+        size_t toWrite = len < pageLeft ? len : pageLeft;
+
+        frame[0] = (uint8_t)(addr >> 8);            // Старший байт адреса
+        frame[1] = (uint8_t)(addr & 0xFF);          // Младший байт адреса
+        memcpy(frame + 2, data, toWrite);
+
+        // Перед каждой страницей ждём окончания цикла записи предыдущей
+        busWrite(EEPROM_ADDR, frame, 2 + toWrite, true, toWrite == len ? cb : nullptr);
+
+        addr += toWrite;
+        data += toWrite;
+        len -= toWrite;
+    }
+    return true;
+}
+
+// По одной странице: любая длина помещается в очередь
+bool eepromWrite(uint16_t addr, const uint8_t *data, size_t len) {
+    if (!busFlush()) return false;
+    while (len > 0) {
+        size_t toWrite = EEPROM_PAGE - (addr % EEPROM_PAGE);
+        if (toWrite > len) toWrite = len;
+        eepromWriteAsync(addr, data, toWrite);
+        if (!busFlush()) return false;
+
+        addr += toWrite;
+        data += toWrite;
+        len -= toWrite;
+    }
+    return true;
+}
+
+bool eepromReadStart(uint16_t addr) {
+    busFlush();                                     // Чтение после уже поставленных записей
+    if (!eepromWaitReady()) return false;
+
+    uint8_t a[2] = {(uint8_t)(addr >> 8), (uint8_t)(addr & 0xFF)};
+    return halI2cWrite(EEPROM_ADDR, a, 2, false) == 0;             // Повторный старт
+}
+
+bool eepromReadNext(uint8_t *buf, size_t len) {
+    while (len > 0) {
+        size_t toRead = len < EEPROM_PAGE ? len : EEPROM_PAGE;          // Буфер Wire — 32 байта
+        if (halI2cRead(EEPROM_ADDR, buf, toRead) != toRead) return false;
+
+        buf += toRead;
+        len -= toRead;
+    }
+    return true;
+}
+
+bool eepromRead(uint16_t addr, uint8_t *buf, size_t len) {
+    return eepromReadStart(addr) && eepromReadNext(buf, len);
+}
@@ -0,0 +1,32 @@
+#ifndef eeprom_h
+#define eeprom_h
+
+// Обмен с EEPROM 24Cxx по I2C.
+// После записи страницы микросхема не отвечает на свой адрес, пока идёт цикл
+// записи. Вместо фиксированной задержки перед каждым обращением адрес
+// опрашивается пустой транзакцией, пока микросхема не ответит (ACK polling).
+// Последний цикл записи при этом идёт параллельно с остальной работой loop().
+// eepromWriteAsync() ставит страницы в очередь шины (bus.h) и сразу возвращается,
+// синхронные функции сначала дожидаются всего, что уже стоит в очереди.
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "bus.h"
+
+bool eepromWaitReady();                                         // false — тайм-аут
+bool eepromWrite(uint16_t addr, const uint8_t *data, size_t len);  // По страницам
+bool eepromRead(uint16_t addr, uint8_t *buf, size_t len);
+
+// Последовательное чтение: адрес передаётся один раз, дальше микросхема сама
+// увеличивает его (current address read), поэтому кусок Wire-буфера стоит
+// одну транзакцию чтения без повторной передачи адреса. Между началом и
+// продолжением к EEPROM не должно быть других обращений
+bool eepromReadStart(uint16_t addr);
+bool eepromReadNext(uint8_t *buf, size_t len);
+
+// Запись по страницам через очередь шины; cb вызывается после последней страницы.
+// Если все страницы не помещаются в очередь, не ставится ни одна: false
+bool eepromWriteAsync(uint16_t addr, const uint8_t *data, size_t len, BusCallback cb = nullptr);
+
+#endif
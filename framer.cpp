@@ -0,0 +1,176 @@
+#include "framer.h"
+
+#include <string.h>
+
+#include "crc.h"
+#include "hal.h"
+#include "ring.h"
+#include "sync.h"
+#include "uart.h"
+
+#define FRAME_MAX (3 + MAX_PAYLOAD_SIZE + 1)   // Начало, команда, длина, данные, CRC
+
+static Ring<64> rx;                 // Буфер приёма: пишет прерывание, читает framerPoll()
+static uint8_t frame[FRAME_MAX];    // Собираемый кадр
+static uint8_t frameLen = 0;        // 0 — ожидание байта начала кадра
+static bool legacy = false;         // Собирается пакет без обрамления
+static bool framedSeen = false;     // Был кадр 0xA5
+static uint32_t framedAt = 0;       // halMillis() последнего кадра 0xA5
+static uint32_t rxAt = 0;           // halMillis() последнего разобранного байта
+static FramerStats stats;
+
+// Длина данных пакетов без обрамления, которые отправляет Cat.aia
+static const uint8_t legacyLen[FRAME_LEGACY_LAST + 1] = {3, 1, 0, 6, 0};
+
+// Длинные кадры бывают только у загрузки расписания. Иначе ложное начало
+// кадра с большой «длиной» поглощало бы следующие кадры до проверки CRC
+static uint8_t maxLen(uint8_t cmd) {
+    return cmd == SYNC_UPLOAD ? MAX_PAYLOAD_SIZE : SHORT_PAYLOAD_SIZE;
+}
+
+// Убрать из начала собранного n байт и всё до следующего байта начала кадра
+static void shift(uint8_t n) {
+    uint8_t i = n;
+    while (i < frameLen && frame[i] != FRAME_SOF) {
+        i++;
+        stats.skipped++;
+    }
+    memmove(frame, frame + i, frameLen - i);
+    frameLen -= i;
+    legacy = false;
+}
+
+// Пакет без обрамления начинается только с байта команды Cat.aia после
+// паузы линии и только пока приложение не перешло на кадры 0xA5
+static bool legacyStart(uint8_t b, bool quiet) {
+    return FRAME_LEGACY && quiet && b <= FRAME_LEGACY_LAST &&
+           (!framedSeen || halMillis() - framedAt >= BLE_SESSION_GAP_MS);
+}
+
+// Пакет без обрамления собран целиком и ждёт паузы после себя
+static bool legacyComplete() {
+    return legacy && frameLen >= 2 && frameLen == 2 + frame[1];
+}
+
+// Пакет без обрамления передаётся обработчику, когда после него
+// FRAME_LEGACY_GAP_MS нет байт: CRC нет, и пакет приложения — вся посылка
+static size_t flushLegacy(FrameHandler handler) {
+    if (!legacyComplete() || halMillis() - rxAt < FRAME_LEGACY_GAP_MS) return 0;
+
+    Packet pkt;
+    pkt.command = frame[0];
+    pkt.len = frame[1];
+    memcpy(pkt.payload, frame + 2, pkt.len);
+    shift(frameLen);
+    stats.legacy++;
+    handler(pkt);
+    return 1;
+}
+
+// Разбор собранных байт: целые кадры передаются обработчику, испорченный
+// кадр теряет байт начала, и поиск продолжается среди уже принятых байт.
+// Цикл без рекурсии: стек не зависит от содержимого кадра
+static size_t scan(FrameHandler handler) {
+    // Длина пакета без обрамления должна совпасть с длиной команды у Cat.aia
+    if (legacy && frameLen >= 2 && frame[1] != legacyLen[frame[0]]) {
+        stats.lenErrors++;
+        shift(1);
+    }
+
+    size_t dispatched = 0;
+    while (!legacy && frameLen >= 3) {
+        uint8_t len = frame[2];
+        if (len > maxLen(frame[1])) {
+            stats.lenErrors++;
+            shift(1);
+            continue;
+        }
+        if (frameLen < 4 + len) break;
+
+        if (crc8(frame + 1, 2 + len) != frame[3 + len]) {
+            stats.crcErrors++;
+            shift(1);
+            continue;
+        }
+
+        Packet pkt;
+        pkt.command = frame[1];
+        pkt.len = len;
+        memcpy(pkt.payload, frame + 3, len);
+        shift(4 + len);
+        stats.frames++;
+        framedSeen = true;
+        framedAt = halMillis();
+        handler(pkt);
+        dispatched++;
+    }
+    return dispatched;
+}
+
+// Разбор одного байта; возвращает количество переданных обработчику кадров
+static size_t feed(uint8_t b, FrameHandler handler) {
+    uint32_t now = halMillis();
+    bool quiet = now - rxAt >= FRAME_LEGACY_GAP_MS;
+    rxAt = now;
+
+    // Байты сразу за пакетом без обрамления: это была часть другой посылки
+    if (legacyComplete()) {
+        stats.lenErrors++;
+        shift(1);
+    }
+
+    if (frameLen == 0 && b != FRAME_SOF) {
+        if (!legacyStart(b, quiet)) {
+            stats.skipped++;
+            return 0;
+        }
+        legacy = true;
+    }
+    frame[frameLen++] = b;
+    return scan(handler);
+}
+
+void framerBegin() {
+    framedSeen = false;
+    halUartAttachRx(framerPush);
+}
+
+void framerPush(uint8_t b) {
+    rx.push(b);
+}
+
+size_t framerPoll(FrameHandler handler) {
+    // Кадр длиннее буфера приёма переносится из буфера ядра частями:
+    // следующая часть — после разбора предыдущей
+    size_t dispatched = 0;
+    uint8_t b;
+    do {
+        while (rx.pop(b)) dispatched += feed(b, handler);
+    } while (halUartService(rx.room()) > 0);
+    dispatched += flushLegacy(handler);
+    stats.overflows = rx.overflows();
+    return dispatched;
+}
+
+bool framerPending() {
+    halUartService(rx.room());
+    return !rx.empty() || legacyComplete();     // Пакет без обрамления ждёт паузы после себя
+}
+
+void framerSend(uint8_t cmd, const uint8_t *payload, uint8_t len) {
+    uint8_t head[3] = {FRAME_SOF, cmd, len};
+    uint8_t crc = crc8(head + 1, 2);
+    crc = crc8(payload, len, crc);
+    uartWriteAll(head, sizeof(head));
+    uartWriteAll(payload, len);
+    uartWriteAll(&crc, 1);
+}
+
+uint32_t framerRoomUs() {
+    size_t free = uartFree();
+    return free >= FRAME_MAX ? 0 : (FRAME_MAX - free) * uartByteUs();
+}
+
+const FramerStats &framerStats() {
+    return stats;
+}
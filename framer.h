@@ -0,0 +1,46 @@
+#ifndef framer_h
+#define framer_h
+
+// Потоковый разбор кадров, приходящих по Serial1 (BLE).
+// Формат кадра: 0xA5 | команда | длина | данные[длина] | CRC-8
+// CRC-8 (полином 0x07, начальное значение 0) считается по команде, длине и данным.
+// Байты складываются в кольцевой буфер из прерывания приёма, а framerPoll()
+// без ожидания разбирает всё накопленное и передаёт каждый целый кадр обработчику.
+// Приложение Cat.aia отправляет пакеты без обрамления: команда | длина | данные,
+// команды 0x00..0x04 с длинами 3, 1, 0, 6, 0, без CRC. При FRAME_LEGACY такой
+// пакет принимается, только если он — вся посылка: до и после него линия молчит
+// FRAME_LEGACY_GAP_MS, длина совпадает с длиной команды, и кадров 0xA5 не было
+// BLE_SESSION_GAP_MS. Поэтому мусор на линии и байты 0x00..0x04 между кадрами
+// нового приложения не становятся командами.
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "crc.h"
+#include "main.h"
+
+#define FRAME_SOF 0xA5      // Байт начала кадра
+#define FRAME_LEGACY_LAST 0x04      // Последняя команда пакетов без обрамления
+#define FRAME_LEGACY_GAP_MS 20      // Пауза линии до и после пакета без обрамления
+
+typedef void (*FrameHandler)(const Packet &pkt);
+
+// Счётчики разбора
+struct FramerStats {
+    uint32_t frames;        // Принятые кадры
+    uint32_t crcErrors;     // Кадры с неверной контрольной суммой
+    uint32_t lenErrors;     // Кадры с длиной больше допустимой для команды
+    uint32_t skipped;       // Байты, отброшенные при поиске начала кадра
+    uint32_t overflows;     // Байты, потерянные из-за переполнения буфера приёма
+    uint32_t legacy;        // Принятые пакеты без обрамления (Cat.aia)
+};
+
+void framerBegin();                         // Подписка на прерывание приёма UART
+void framerPush(uint8_t b);                 // Байт из прерывания приёма
+size_t framerPoll(FrameHandler handler);    // Разобрать накопленное, вернуть число кадров
+bool framerPending();                       // Есть принятые и ещё не разобранные байты
+void framerSend(uint8_t cmd, const uint8_t *payload, uint8_t len);  // В очередь передачи (uart.h)
+uint32_t framerRoomUs();                    // Через сколько кадр наибольшей длины поместится в очередь передачи
+const FramerStats &framerStats();
+
+#endif
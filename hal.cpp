@@ -0,0 +1,194 @@
+#include "hal.h"
+
+#include "Arduino.h"
+#include "Wire.h"
+
+#include "MDR32F9Qx_rst_clk.h"
+#include "MDR32F9Qx_timer.h"
+#include "MDR32F9Qx_uart.h"
+
+#include "config.h"
+
+// Регистры DWT и CoreDebug ядра Cortex-M3
+#define DWT_CTRL (*(volatile uint32_t *)0xE0001000)
+#define DWT_CYCCNT (*(volatile uint32_t *)0xE0001004)
+#define CORE_DEMCR (*(volatile uint32_t *)0xE000EDFC)
+#define DEMCR_TRCENA (1UL << 24)
+#define DWT_CYCCNTENA 1UL
+
+// Serial1 (модуль BLE) — UART2. Приём и его прерывание обслуживает ядро,
+// передача без ожидания пишет в FIFO напрямую
+#define BLE_UART MDR_UART2
+
+// Таймеры HAL: TIMER2, TIMER3 и TIMER1, счёт с частотой 1 МГц
+static MDR_TIMER_TypeDef *const timerRegs[] = {MDR_TIMER2, MDR_TIMER3, MDR_TIMER1};
+static const uint32_t timerClocks[] = {RST_CLK_PCLK_TIMER2, RST_CLK_PCLK_TIMER3, RST_CLK_PCLK_TIMER1};
+static const IRQn_Type timerIrqs[] = {Timer2_IRQn, Timer3_IRQn, Timer1_IRQn};
+static volatile HalTimerCallback timerCallbacks[3];
+
+void halI2cBegin() {
+    Wire.begin();
+    Wire.setClock(I2C_CLOCK_HZ);
+}
+
+uint8_t halI2cWrite(uint8_t addr, const uint8_t *data, size_t len, bool stop) {
+    Wire.beginTransmission(addr);
+    Wire.write(data, len);
+    return Wire.endTransmission(stop);
+}
+
+size_t halI2cRead(uint8_t addr, uint8_t *buf, size_t len) {
+    size_t received = Wire.requestFrom(addr, (uint8_t)len);
+    size_t n = 0;
+    while (n < received && n < len && Wire.available()) {
+        buf[n++] = Wire.read();
+    }
+    return n;
+}
+
+void halUartBegin(uint32_t baud) {
+    Serial1.begin(baud);
+}
+
+int halUartAvailable() {
+    return Serial1.available();
+}
+
+int halUartRead() {
+    return Serial1.read();
+}
+
+size_t halUartReadBytes(uint8_t *buf, size_t len) {
+    return Serial1.readBytes(buf, len);
+}
+
+size_t halUartWrite(const uint8_t *data, size_t len) {
+    return Serial1.write(data, len);
+}
+
+bool halUartTxReady() {
+    return !(BLE_UART->FR & UART_FR_TXFF);
+}
+
+void halUartTxPut(uint8_t b) {
+    BLE_UART->DR = b;
+}
+
+bool halUartTxDone() {
+    return !(BLE_UART->FR & UART_FR_BUSY);
+}
+
+static HalRxCallback uartRx = nullptr;
+
+void halUartAttachRx(HalRxCallback cb) {
+    uartRx = cb;
+}
+
+// Прерывание приёма Serial1 принадлежит ядру: забираем накопленные им байты,
+// сколько вмещает буфер получателя
+size_t halUartService(size_t room) {
+    if (!uartRx) return 0;
+    size_t n = 0;
+    while (n < room && Serial1.available() > 0) {
+        uartRx((uint8_t)Serial1.read());
+        n++;
+    }
+    return n;
+}
+
+void halPinOutput(uint8_t pin) {
+    pinMode(pin, OUTPUT);
+}
+
+void halPinWrite(uint8_t pin, bool value) {
+    digitalWrite(pin, value);
+}
+
+void halTimerStart(uint8_t timer, uint32_t periodUs, HalTimerCallback isr) {
+    MDR_TIMER_TypeDef *t = timerRegs[timer];
+    timerCallbacks[timer] = isr;
+
+    RST_CLK_PCLKcmd(timerClocks[timer], ENABLE);
+    TIMER_DeInit(t);
+    TIMER_BRGInit(t, TIMER_HCLKdiv1);
+
+    TIMER_CntInitTypeDef cnt;
+    TIMER_CntStructInit(&cnt);
+    cnt.TIMER_Prescaler = F_CPU / 1000000 - 1;   // 1 тик = 1 мкс
+    cnt.TIMER_Period = periodUs - 1;
+    TIMER_CntInit(t, &cnt);
+
+    TIMER_ClearFlag(t, TIMER_STATUS_CNT_ARR);
+    TIMER_ITConfig(t, TIMER_STATUS_CNT_ARR, ENABLE);
+    NVIC_EnableIRQ(timerIrqs[timer]);
+    TIMER_Cmd(t, ENABLE);
+}
+
+void halTimerSetPeriod(uint8_t timer, uint32_t periodUs) {
+    TIMER_SetCntAutoreload(timerRegs[timer], periodUs - 1);
+}
+
+void halTimerStop(uint8_t timer) {
+    TIMER_Cmd(timerRegs[timer], DISABLE);
+    TIMER_ITConfig(timerRegs[timer], TIMER_STATUS_CNT_ARR, DISABLE);
+    NVIC_DisableIRQ(timerIrqs[timer]);
+}
+
+static void timerIrq(uint8_t timer) {
+    TIMER_ClearFlag(timerRegs[timer], TIMER_STATUS_CNT_ARR);
+    HalTimerCallback cb = timerCallbacks[timer];
+    if (cb) cb();
+}
+
+extern "C" void Timer2_IRQHandler() {
+    timerIrq(0);
+}
+
+extern "C" void Timer3_IRQHandler() {
+    timerIrq(1);
+}
+
+extern "C" void Timer1_IRQHandler() {
+    timerIrq(2);
+}
+
+void halPinInputPullup(uint8_t pin) {
+    pinMode(pin, INPUT_PULLUP);
+}
+
+bool halPinRead(uint8_t pin) {
+    return digitalRead(pin);
+}
+
+uint32_t halMillis() {
+    return millis();
+}
+
+uint32_t halMicros() {
+    return micros();
+}
+
+void halDelayMs(uint32_t ms) {
+    delay(ms);
+}
+
+void halDelayUs(uint32_t us) {
+    delayMicroseconds(us);
+}
+
+// Прерывание SysTick ядра Arduino будит ядро каждую миллисекунду, поэтому
+// отдельный таймер для maxUs не нужен: idle.cpp проверяет срок и засыпает снова
+void halSleepUs(uint32_t maxUs) {
+    (void)maxUs;
+    __WFI();
+}
+
+void halCyclesBegin() {
+    CORE_DEMCR |= DEMCR_TRCENA;     // Без TRCENA блок DWT не тактируется
+    DWT_CYCCNT = 0;
+    DWT_CTRL |= DWT_CYCCNTENA;
+}
+
+uint32_t halCycles() {
+    return DWT_CYCCNT;
+}
@@ -0,0 +1,69 @@
+#ifndef hal_h
+#define hal_h
+
+// Тонкий слой абстракции оборудования (HAL).
+// Логика скетча обращается к шине I2C, UART (BLE), GPIO и часам только через
+// эти функции. На плате они реализованы в hal.cpp поверх ядра Arduino,
+// при нативной сборке — в host/hal_host.cpp поверх поддельных устройств.
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Шина I2C
+void halI2cBegin();
+// Передача len байт устройству addr. Возвращает 0 при успехе (как Wire.endTransmission)
+uint8_t halI2cWrite(uint8_t addr, const uint8_t *data, size_t len, bool stop = true);
+// Чтение до len байт от устройства addr. Возвращает количество прочитанных байт
+size_t halI2cRead(uint8_t addr, uint8_t *buf, size_t len);
+
+// UART модуля BLE
+void halUartBegin(uint32_t baud);
+int halUartAvailable();
+int halUartRead();                                              // -1, если данных нет
+size_t halUartReadBytes(uint8_t *buf, size_t len);              // блокирующее чтение с тайм-аутом
+size_t halUartWrite(const uint8_t *data, size_t len);           // блокирующая передача
+
+// Передача без ожидания — аппаратный FIFO передатчика (16 байт). Прерывание
+// UART занято ядром Arduino, поэтому FIFO подкачивает таймер HAL_TIMER_UART (uart.h)
+bool halUartTxReady();                                          // В FIFO передатчика есть место
+void halUartTxPut(uint8_t b);                                   // Только если halUartTxReady()
+bool halUartTxDone();                                           // FIFO пуст, последний байт ушёл в линию
+
+// Приём по прерыванию: cb вызывается для каждого принятого байта.
+// halUartService() вызывается из loop() и переносит байты, если прерывание
+// приёма обслуживает ядро, а не HAL: не больше room, остальные ждут в буфере ядра
+typedef void (*HalRxCallback)(uint8_t b);
+void halUartAttachRx(HalRxCallback cb);
+size_t halUartService(size_t room);                             // Перенесено байт
+
+// Цифровые выводы
+void halPinOutput(uint8_t pin);
+void halPinWrite(uint8_t pin, bool value);
+void halPinInputPullup(uint8_t pin);
+bool halPinRead(uint8_t pin);
+
+// Аппаратные таймеры: периодический вызов isr из прерывания
+#define HAL_TIMER_MOTION 0          // Таймер генератора шагов
+#define HAL_TIMER_UART 1            // Таймер подкачки FIFO передатчика UART
+#define HAL_TIMER_SOUND 2           // Таймер нот пищалки
+
+typedef void (*HalTimerCallback)();
+void halTimerStart(uint8_t timer, uint32_t periodUs, HalTimerCallback isr);
+void halTimerSetPeriod(uint8_t timer, uint32_t periodUs);      // Новый период со следующего срабатывания
+void halTimerStop(uint8_t timer);
+
+// Монотонные часы
+uint32_t halMillis();
+uint32_t halMicros();
+void halDelayMs(uint32_t ms);
+void halDelayUs(uint32_t us);
+
+// Остановить ядро до прерывания (WFI), но не дольше maxUs.
+// Может вернуться раньше по любому прерыванию: условие пробуждения проверяет вызывающий
+void halSleepUs(uint32_t maxUs);
+
+// Счётчик тактов ядра (DWT CYCCNT), переполняется за 2^32 такта — 53 с на 80 МГц
+void halCyclesBegin();
+uint32_t halCycles();
+
+#endif
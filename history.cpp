@@ -0,0 +1,228 @@
+#include "history.h"
+
+#include <string.h>
+
+#include "crc.h"
+#include "eeprom.h"
+#include "framer.h"
+
+static_assert(HISTORY_ADDR % EEPROM_PAGE == 0 && HISTORY_PAGES >= 2, "History must be whole EEPROM pages");
+static_assert(HISTORY_PER_FRAME >= 1, "A history page must fit one frame");
+
+#define HISTORY_VARINT_MAX 4        // Разность времени до 2^28 с, иначе новая страница
+#define HISTORY_RECORD_MAX (2 + HISTORY_VARINT_MAX)
+
+static uint8_t head = 0;            // Текущая страница
+static bool pageOpen = false;       // Текущая страница начата
+static uint32_t lastEpoch = 0;      // Время последнего события текущей страницы
+
+// Выгрузка
+static bool streaming = false;
+static uint16_t cursor = 0;         // Номер следующей страницы для передачи
+static uint8_t gap = 0;             // HISTORY_GAP для первого кадра
+
+static HistoryStats stats;
+
+static uint16_t get16(const uint8_t *p) { return p[0] | (p[1] << 8); }
+
+static uint32_t get32(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint16_t pageAddr(uint8_t page) {
+    return HISTORY_ADDR + page * EEPROM_PAGE;
+}
+
+// Заголовок страницы; false — страница не начата или испорчена
+static bool readHead(const uint8_t *p, uint16_t &seq, uint32_t &base) {
+    seq = get16(p);
+    base = get32(p + 2);
+    return base != 0xFFFFFFFF && crc8(p, HISTORY_PAGE_HEAD - 1) == p[HISTORY_PAGE_HEAD - 1];
+}
+
+// Разбор событий страницы: занятая часть и время последнего события.
+// Разбор останавливается на 0xFF, неверном байте причины или событии,
+// выходящем за страницу (оборванная запись)
+static uint8_t parsePage(const uint8_t *p, uint32_t base, uint32_t &last) {
+    uint8_t at = HISTORY_PAGE_HEAD;
+    last = base;
+    while (at + 3 <= EEPROM_PAGE) {
+        uint8_t h = p[at];
+        if ((h & 0xC0) || ((h >> 4) & 0x03) > HISTORY_DROPPED) break;
+        uint8_t i = at + 2;
+        uint32_t delta = 0;
+        uint8_t shift = 0;
+        bool more = true;
+        while (more && i < EEPROM_PAGE && shift < 7 * HISTORY_VARINT_MAX) {
+            delta |= (uint32_t)(p[i] & 0x7F) << shift;
+            more = p[i++] & 0x80;
+            shift += 7;
+        }
+        if (more) break;
+        last += delta;
+        at = i;
+    }
+    return at;
+}
+
+static uint8_t encode(uint8_t *rec, uint8_t cause, uint8_t task, uint8_t portions, uint32_t delta) {
+    rec[0] = (portions & 0x0F) | (cause & 0x03) << 4;
+    rec[1] = task;
+    uint8_t n = 2;
+    do {
+        rec[n] = delta & 0x7F;
+        delta >>= 7;
+        if (delta) rec[n] |= 0x80;
+        n++;
+    } while (delta);
+    return n;
+}
+
+// Самая старая страница, которая ещё хранится
+static uint16_t oldest() {
+    return stats.seq - (stats.valid ? stats.valid - 1 : 0);
+}
+
+static bool pageHead(uint8_t page, uint16_t &seq, uint32_t &base) {
+    uint8_t h[HISTORY_PAGE_HEAD];
+    return eepromRead(pageAddr(page), h, sizeof(h)) && readHead(h, seq, base);
+}
+
+// Страницы пишутся по кругу, номер каждой новой на единицу больше прошлой.
+// Текущая — страница с самым новым номером среди целых заголовков. Страница
+// с испорченным заголовком не обрывает кольцо: она выдаётся пустой и
+// перезаписывается в свой черёд, а страницы до неё сохраняются. Кольцо
+// кончается на странице, чей номер не совпадает с её местом от текущей
+void historyBegin() {
+    pageOpen = false;
+    head = 0;
+    stats.valid = 0;
+    stats.used = 0;
+    streaming = false;
+
+    uint16_t seqs[HISTORY_PAGES];
+    uint8_t good[(HISTORY_PAGES + 7) / 8];
+    memset(good, 0, sizeof(good));
+    uint16_t seq;
+    uint32_t base;
+    for (uint16_t page = 0; page < HISTORY_PAGES; page++) {
+        if (!pageHead(page, seqs[page], base)) continue;
+        good[page / 8] |= 1 << (page % 8);
+        if (!pageOpen || (int16_t)(seqs[page] - stats.seq) > 0) {
+            head = page;
+            stats.seq = seqs[page];
+            pageOpen = true;
+        }
+    }
+    if (!pageOpen) return;
+
+    stats.valid = 1;
+    for (uint16_t back = 1; back < HISTORY_PAGES; back++) {
+        uint8_t page = (head + HISTORY_PAGES - back) % HISTORY_PAGES;
+        if (!(good[page / 8] & (1 << (page % 8)))) continue;
+        if (seqs[page] != (uint16_t)(stats.seq - back)) break;
+        stats.valid = back + 1;
+    }
+
+    // Текущая страница не прочиталась: следующее событие начнёт новую
+    uint8_t p[EEPROM_PAGE];
+    if (eepromRead(pageAddr(head), p, sizeof(p)) && readHead(p, seq, base)) stats.used = parsePage(p, base, lastEpoch);
+    else stats.used = EEPROM_PAGE;
+}
+
+// Новая страница с первым событием: вся страница одной записью.
+// false — страница не поставлена в очередь шины, текущая остаётся прежней
+static bool startPage(uint32_t epoch, const uint8_t *rec, uint8_t n) {
+    uint8_t page = pageOpen ? (head + 1) % HISTORY_PAGES : head;
+    uint16_t seq = pageOpen ? stats.seq + 1 : stats.seq;
+
+    uint8_t p[EEPROM_PAGE];
+    memset(p, 0xFF, sizeof(p));
+    p[0] = seq & 0xFF;
+    p[1] = seq >> 8;
+    for (uint8_t b = 0; b < 4; b++) p[2 + b] = epoch >> (8 * b);
+    p[HISTORY_PAGE_HEAD - 1] = crc8(p, HISTORY_PAGE_HEAD - 1);
+    memcpy(p + HISTORY_PAGE_HEAD, rec, n);
+    if (!eepromWriteAsync(pageAddr(page), p, sizeof(p))) return false;
+
+    head = page;
+    stats.seq = seq;
+    if (stats.valid < HISTORY_PAGES) stats.valid++;
+    pageOpen = true;
+    stats.used = HISTORY_PAGE_HEAD + n;
+    stats.pages++;
+    return true;
+}
+
+// Событие, не поставленное в очередь шины, теряется целиком: время следующего
+// отсчитывается от последнего записанного
+void historyAppend(uint32_t epoch, uint8_t cause, uint8_t task, uint8_t portions) {
+    uint8_t rec[HISTORY_RECORD_MAX];
+    uint32_t delta = epoch - lastEpoch;
+    bool fits = pageOpen && epoch >= lastEpoch && delta < (1UL << (7 * HISTORY_VARINT_MAX));
+    uint8_t n = fits ? encode(rec, cause, task, portions, delta) : 0;
+    bool ok;
+    if (fits && stats.used + n <= EEPROM_PAGE) {
+        ok = eepromWriteAsync(pageAddr(head) + stats.used, rec, n);
+        if (ok) stats.used += n;
+    } else {
+        n = encode(rec, cause, task, portions, 0);
+        ok = startPage(epoch, rec, n);
+    }
+    if (!ok) {
+        stats.lost++;
+        return;
+    }
+    lastEpoch = epoch;
+    stats.events++;
+}
+
+void historyRequest(const Packet &pkt) {
+    uint16_t from = oldest();
+    gap = 0;
+    if (pkt.len >= 2) {
+        uint16_t want = get16(pkt.payload);
+        // Страницы старше самой старой уже перезаписаны, новее текущей ещё нет
+        if ((int16_t)(want - from) < 0) gap = HISTORY_GAP;
+        else if ((int16_t)(want - stats.seq) <= 0) from = want;
+        else from = stats.seq + 1;
+    }
+    cursor = from;
+    streaming = true;
+}
+
+void historyPoll() {
+    if (!streaming || !busIdle() || framerRoomUs() != 0) return;
+
+    uint8_t frame[MAX_PAYLOAD_SIZE];
+    frame[0] = cursor & 0xFF;
+    frame[1] = cursor >> 8;
+    uint8_t len = HISTORY_FRAME_HEAD;
+    for (uint8_t n = 0; n < HISTORY_PER_FRAME && stats.valid && (int16_t)(cursor - stats.seq) <= 0; n++) {
+        uint8_t page = (head + HISTORY_PAGES - (uint16_t)(stats.seq - cursor)) % HISTORY_PAGES;
+        uint8_t *out = frame + len + 1;
+        uint16_t seq;
+        uint32_t base, last;
+        uint8_t used = 0;
+        if (eepromRead(pageAddr(page), out, EEPROM_PAGE) && readHead(out, seq, base) && seq == cursor) {
+            used = parsePage(out, base, last);
+        }
+        frame[len] = used;
+        len += 1 + used;
+        cursor++;
+    }
+    bool last = !stats.valid || (int16_t)(cursor - stats.seq) > 0;
+    frame[2] = gap | (last ? HISTORY_LAST : 0);
+    gap = 0;
+    framerSend(HISTORY_REPLY, frame, len);
+    stats.frames++;
+    if (last) streaming = false;
+}
+
+bool historyStreaming() {
+    return streaming;
+}
+
+const HistoryStats &historyStats() {
+    return stats;
+}
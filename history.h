@@ -0,0 +1,66 @@
+#ifndef history_h
+#define history_h
+
+// История кормлений в EEPROM после журнала изменений расписания.
+// Область HISTORY_ADDR..EEPROM_SIZE — кольцо страниц по EEPROM_PAGE байт,
+// самая старая страница перезаписывается целиком. Страница:
+//   номер страницы (2) | время начала, секунды от 2000 года (4) | CRC8 (1) |
+//   события до конца страницы или до байта 0xFF.
+// Событие — 3..6 байт:
+//   байт 0: биты 0..3 — порции, биты 4..5 — причина (HistoryCause), биты 6..7 — 0;
+//   байт 1: номер задачи (по расписанию) или канал двигателя (0x04, отказ);
+//   далее секунды от предыдущего события страницы (первое — от начала
+//   страницы), по 7 бит на байт, младшие первыми, старший бит — «есть ещё».
+// Событие, не помещающееся в страницу, или время раньше предыдущего
+// (часы переведены назад) начинает новую страницу.
+// Новая страница пишется целиком (остаток — 0xFF), событие в начатую —
+// только своими байтами; всё через очередь шины (bus.h).
+//
+// 0x08 — выгрузка: запрос [номер первой страницы (2)], без него — с самой старой.
+//   Ответ — кадры 0x88: номер первой страницы кадра (2) | флаги (1) |
+//   страницы по HISTORY_PER_FRAME: длина (1) и занятая часть страницы.
+//   Кадры уходят по одному за проход loop(), когда в очереди передачи есть
+//   место, поэтому выгрузку можно продолжить с любой страницы.
+
+#include <stdint.h>
+
+#include "config.h"
+#include "main.h"
+
+#define HISTORY_COMMAND 0x08
+#define HISTORY_REPLY 0x88
+
+#define HISTORY_PAGES (HISTORY_SIZE / EEPROM_PAGE)
+#define HISTORY_PAGE_HEAD 7
+#define HISTORY_FRAME_HEAD 3
+#define HISTORY_PER_FRAME ((MAX_PAYLOAD_SIZE - HISTORY_FRAME_HEAD) / (EEPROM_PAGE + 1))
+
+// Флаги кадра ответа
+#define HISTORY_LAST 0x01           // Последний кадр: страница в нём — текущая
+#define HISTORY_GAP 0x02            // Запрошенные страницы уже перезаписаны
+
+enum HistoryCause : uint8_t {
+    HISTORY_SCHEDULED,      // Кормление по расписанию выдано
+    HISTORY_MANUAL,         // Порция по команде 0x04 выдана
+    HISTORY_DROPPED         // Кормление не поставлено: очередь канала заполнена или канала нет
+};
+
+// Счётчики истории
+struct HistoryStats {
+    uint32_t events;        // Записанные события
+    uint32_t pages;         // Начатые страницы
+    uint32_t frames;        // Кадры выгрузки
+    uint32_t lost;          // События, не записанные: очередь шины заполнена
+    uint16_t seq;           // Номер текущей страницы
+    uint8_t used;           // Занято в текущей странице, байт
+    uint8_t valid;          // Страниц с историей
+};
+
+void historyBegin();        // Найти текущую страницу (чтение заголовков страниц)
+void historyAppend(uint32_t epoch, uint8_t cause, uint8_t task, uint8_t portions);
+void historyRequest(const Packet &pkt);     // Команда 0x08
+void historyPoll();                         // Вызывать из loop(): очередной кадр выгрузки
+bool historyStreaming();                    // Выгрузка не закончена
+const HistoryStats &historyStats();
+
+#endif
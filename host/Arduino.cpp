@@ -0,0 +1,46 @@
+#include "Arduino.h"
+
+#include <stdio.h>
+
+#include "fake.h"
+
+HostSerial Serial;
+
+void HostSerial::begin(uint32_t baud) {
+    baud_ = baud;
+}
+
+size_t HostSerial::emit(const char *s, size_t len) {
+    if (echo) fwrite(s, 1, len, stdout);
+    if (capture) captured.insert(captured.end(), s, s + len);
+    bytesWritten += len;
+    fakeAdvance(len * 10000000ULL / baud_);  // Блокирующая передача: 10 бит на байт
+    return len;
+}
+
+size_t HostSerial::print(const char *s) {
+    return emit(s, strlen(s));
+}
+
+size_t HostSerial::print(char c) {
+    return emit(&c, 1);
+}
+
+size_t HostSerial::print(long n, int base) {
+    if (base == DEC) {
+        char buf[24];
+        int len = snprintf(buf, sizeof(buf), "%ld", n);
+        return emit(buf, len);
+    }
+    return print((unsigned long)n, base);
+}
+
+size_t HostSerial::print(unsigned long n, int base) {
+    char buf[24];
+    int len = snprintf(buf, sizeof(buf), base == HEX ? "%lX" : "%lu", n);
+    return emit(buf, len);
+}
+
+size_t HostSerial::println() {
+    return emit("\r\n", 2);
+}
@@ -0,0 +1,67 @@
+#ifndef Arduino_h
+#define Arduino_h
+
+// Минимальная замена ядра Arduino для нативной сборки.
+// Периферия (I2C, UART, GPIO, часы) доступна скетчу только через hal.h,
+// здесь остаются лишь утилиты ядра и отладочный порт Serial.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <vector>
+
+#define HEX 16
+#define DEC 10
+
+#define OUTPUT 1
+
+// Сравнение в общем типе аргументов, как в макросах ядра, но без -Wsign-compare
+template <typename A, typename B>
+static inline auto min(A a, B b) -> decltype(a < b ? a : b) {
+    typedef decltype(a < b ? a : b) T;
+    return (T)a < (T)b ? a : b;
+}
+
+template <typename A, typename B>
+static inline auto max(A a, B b) -> decltype(a > b ? a : b) {
+    typedef decltype(a > b ? a : b) T;
+    return (T)a > (T)b ? a : b;
+}
+
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+// Отладочный порт: считает переданные байты и занимает время передачи
+// на 115200 бод, как блокирующий Serial.print на плате
+class HostSerial {
+public:
+    void begin(uint32_t baud);
+
+    size_t print(const char *s);
+    size_t print(char c);
+    size_t print(long n, int base = DEC);
+    size_t print(unsigned long n, int base = DEC);
+    size_t print(int n, int base = DEC) { return print((long)n, base); }
+    size_t print(unsigned int n, int base = DEC) { return print((unsigned long)n, base); }
+    size_t print(unsigned char n, int base = DEC) { return print((unsigned long)n, base); }
+
+    size_t write(const uint8_t *data, size_t len) { return emit((const char *)data, len); }
+
+    size_t println();
+    template <typename T>
+    size_t println(T v) { return print(v) + println(); }
+    template <typename T>
+    size_t println(T v, int base) { return print(v, base) + println(); }
+
+    uint32_t bytesWritten = 0;  // Всего байт отправлено в отладочный порт
+    bool echo = false;          // Дублировать вывод в stdout
+    bool capture = false;       // Сохранять вывод в captured
+    std::vector<uint8_t> captured;
+
+private:
+    size_t emit(const char *s, size_t len);
+    uint32_t baud_ = 115200;
+};
+
+extern HostSerial Serial;
+
+#endif
@@ -0,0 +1,1864 @@
+// Микробенчмарк логики скетча на поддельных устройствах.
+// Для каждой операции выводится среднее время на хосте, среднее и худшее
+// время на виртуальных часах (шина I2C на I2C_CLOCK_HZ, UART и задержки ядра)
+// и среднее число транзакций I2C на вызов.
+// Проверки корректности (verify) печатают FAIL и дают ненулевой код выхода,
+// поэтому bench зарегистрирован в ctest.
+
+#include <math.h>
+#include <stdio.h>
+#include <time.h>
+#include <chrono>
+#include <algorithm>
+#include <vector>
+
+#include "Arduino.h"
+#include "bcd.h"
+#include "bus.h"
+#include "calendar.h"
+#include "check.h"
+#include "fake.h"
+#include "main.h"
+#include "motion.h"
+#include "prof.h"
+#include "ramp.h"
+#include "framer.h"
+#include "history.h"
+#include "scheduler.h"
+#include "sound.h"
+#include "store.h"
+#include "sync.h"
+#include "tasks.h"
+#include "hal.h"
+#include "ble.h"
+#include "uart.h"
+#include "idle.h"
+
+#define F_CPU_HOST 80000000.0   // Частота ядра платы для пересчёта тактов
+
+static void header(const char *title) {
+    printf("\n== %s\n", title);
+    printf("%-34s %10s %12s %12s %10s\n", "operation", "host ns", "virt us", "worst us", "i2c tx");
+}
+
+// prep выполняется перед каждым вызовом и в замер не входит
+template <typename Prep, typename Fn>
+static void measure(const char *name, int iterations, Prep prep, Fn fn) {
+    double hostNs = 0, virtUs = 0, worstUs = 0, transactions = 0;
+    for (int i = 0; i < iterations; i++) {
+        prep();
+        uint32_t tx0 = board.bus.stats.transactions;
+        uint64_t v0 = fakeNow();
+        auto h0 = std::chrono::steady_clock::now();
+        fn();
+        auto h1 = std::chrono::steady_clock::now();
+        double v = (double)(fakeNow() - v0);
+        hostNs += std::chrono::duration<double, std::nano>(h1 - h0).count();
+        virtUs += v;
+        if (v > worstUs) worstUs = v;
+        transactions += board.bus.stats.transactions - tx0;
+    }
+    printf("%-34s %10.0f %12.1f %12.1f %10.2f\n", name,
+           hostNs / iterations, virtUs / iterations, worstUs, transactions / iterations);
+}
+
+template <typename Fn>
+static void measure(const char *name, int iterations, Fn fn) {
+    measure(name, iterations, [] {}, fn);
+}
+
+// Сборка кадра 0xA5 | команда | длина | данные | CRC-8
+static size_t makeFrame(uint8_t cmd, const uint8_t *payload, uint8_t len, uint8_t *out) {
+    out[0] = FRAME_SOF;
+    out[1] = cmd;
+    out[2] = len;
+    if (len) memcpy(out + 3, payload, len);
+    out[3 + len] = crc8(out + 1, 2 + len);
+    return 4 + len;
+}
+
+// Поставить кадр в UART и дождаться его полного приёма
+static void feedPacket(uint8_t cmd, const uint8_t *payload, uint8_t len) {
+    uint8_t frame[4 + MAX_PAYLOAD_SIZE];
+    size_t n = makeFrame(cmd, payload, len, frame);
+    board.uart.feed(frame, n);
+    fakeAdvance(n * board.uart.byteTimeUs());
+}
+
+static void benchSketch() {
+    header("sketch");
+
+    measure("getTime", 1000, [] { Time t; getTime(t); });
+
+    measure("readPacket (0x02 list)", 200,
+            [] { feedPacket(0x02, nullptr, 0); },
+            [] { readPacket(); });
+
+    // Кадр пришёл не полностью: readPacket() не ждёт остальные байты
+    measure("readPacket (partial frame)", 20,
+            [] { uint8_t f[] = {FRAME_SOF, 0x00, 3, 8, 30}; board.uart.feed(f, sizeof(f)); fakeAdvance(sizeof(f) * board.uart.byteTimeUs()); },
+            [] { readPacket(); });
+    // Хвост последнего неполного кадра: остаток и CRC
+    { uint8_t f[] = {FRAME_SOF, 0x00, 3, 8, 30, 1}; uint8_t tail[] = {1, crc8(f + 1, 5)};
+      board.uart.feed(tail, sizeof(tail)); fakeAdvance(sizeof(tail) * board.uart.byteTimeUs()); readPacket(); }
+
+    Packet add = {0x00, {8, 30, 1}, 3};
+    measure("handleCommand (0x00 add)", 200, [&] { handleCommand(add); });
+
+    Packet list = {0x02, {0}, 0};
+    measure("handleCommand (0x02 list)", 200, [&] { handleCommand(list); });
+    Packet fullList = {TASK_LIST_COMMAND, {0}, 0};
+    measure("handleCommand + taskListPoll (0x09)", 200,
+            [] { uartFlush(); },
+            [&] { handleCommand(fullList); taskListPoll(); });
+
+    Packet set = {0x03, {0, 30, 12, 15, 6, 25}, 6};
+    measure("handleCommand (0x03 set time)", 200, [&] { handleCommand(set); });
+
+    static uint8_t minute = 0;
+    measure("addTask (queued)", 200,
+            [] { busFlush(); },
+            [] { addTask(4, Time{6, (uint8_t)(minute++ % 60)}); });
+    measure("addTask + busFlush (written)", 200,
+            [] { addTask(4, Time{6, (uint8_t)(minute++ % 60)}); busFlush(); });
+
+    measure("storeBegin (boot load)", 20, [] { storeBegin(nullptr, 0); });
+
+    measure("loop (idle pass)", 1000, [] { loop(); });
+}
+
+// Выдача порции: loop() продолжает работать, пока таймер формирует шаги
+// Заданная скорость на шаге k перемещения из iter шагов: разгон по пройденному
+// пути, торможение по оставшемуся, не выше полной скорости. Считается заново
+// по формулам ramp.h в double, без таблиц
+static double intendedVelocity(int shape, uint16_t iter, double k) {
+    const double v0 = MOTION_START_HZ, v1 = 500000.0 / SPEED;
+    auto ramp = [&](double accel, double s) {
+        double T = (v1 - v0) / accel;
+        if (s >= (v0 + v1) * T / 2) return v1;
+        return rampVelocity(shape, v0, v1, T, rampTime(shape, v0, v1, T, s));
+    };
+    double v = ramp(MOTION_ACCEL, k + 0.5);
+    double d = ramp(MOTION_DECEL, iter - k - 0.5);
+    return v < d ? v : d;
+}
+
+// Последовательность импульсов против заданной кривой скорости. Скорость шага —
+// по периоду между спадами. Ускорение — по средним скоростям соседних окон
+// из ACCEL_WINDOW шагов: округление полупериодов до 1 мкс не выдаётся за рывки
+#define ACCEL_WINDOW 32
+static void checkPulseTrain(const std::vector<uint64_t> &edges, int shape, uint16_t iter) {
+    double worstErr = 0, sumErr2 = 0, peakAccel = 0, vPeak = 0;
+    size_t steps = 0;
+    for (size_t k = 1; 2 * k + 1 < edges.size(); k++, steps++) {
+        double v = 1e6 / (double)(edges[2 * k + 1] - edges[2 * k - 1]);
+        double expect = intendedVelocity(shape, iter, (double)k);
+        double err = (v - expect) / expect;
+        if (fabs(err) > worstErr) worstErr = fabs(err);
+        sumErr2 += err * err;
+        if (v > vPeak) vPeak = v;
+    }
+
+    double vPrev = 0, tPrev = 0;
+    for (size_t k = 0; 2 * (k + ACCEL_WINDOW) + 1 < edges.size(); k += ACCEL_WINDOW) {
+        double t0 = edges[2 * k + 1] / 1e6, t1 = edges[2 * (k + ACCEL_WINDOW) + 1] / 1e6;
+        double v = ACCEL_WINDOW / (t1 - t0), t = (t0 + t1) / 2;
+        if (vPrev > 0 && fabs(v - vPrev) / (t - tPrev) > peakAccel) peakAccel = fabs(v - vPrev) / (t - tPrev);
+        vPrev = v;
+        tPrev = t;
+    }
+    double accelLimit = MOTION_ACCEL * (shape == RAMP_S_CURVE ? 1.5 : 1.0);
+    printf("velocity vs %s curve: %zu steps, error rms %.2f%%, worst %.2f%%; peak %.0f steps/s, "
+           "peak accel %.0f steps/s^2 (limit %.0f)\n",
+           shape == RAMP_S_CURVE ? "S" : "trapezoid", steps, 100 * sqrt(sumErr2 / steps), 100 * worstErr,
+           vPeak, peakAccel, accelLimit);
+    verify(steps + 1 == iter, "pulse train has a different number of steps");
+    verify(worstErr < 0.01, "step velocity strays more than 1% from the ramp curve");
+    verify(peakAccel <= accelLimit, "acceleration exceeds the ramp limit");
+}
+
+// Таблицы обеих форм: полупериод против заданной скорости в середине шага
+template <int Shape>
+static void checkRampTable(const char *name) {
+    static constexpr RampTable<Shape, MOTION_START_HZ, 500000UL / SPEED, MOTION_ACCEL> table{};
+    double worst = 0;
+    for (uint16_t n = 0; n < table.size; n++) {
+        double expect = 500000.0 / intendedVelocity(Shape, 0xFFFF, n);
+        double err = fabs(table.half[n] - expect);
+        if (err > worst) worst = err;
+    }
+    printf("%-10s ramp table: %u steps, %zu bytes, %.1f ms, half-period %u..%u us, worst %.2f us from curve\n",
+           name, table.size, sizeof(table.half), table.T * 1000, table.half[0], table.half[table.size - 1], worst);
+    // Полупериоды округлены до целых микросекунд
+    verify(worst <= 0.5 + 1e-6, "ramp table strays from the curve by more than rounding");
+}
+
+static void checkRampTables() {
+    checkRampTable<RAMP_TRAPEZOID>("trapezoid");
+    checkRampTable<RAMP_S_CURVE>("S-curve");
+}
+
+static void benchMotion() {
+    header("motion");
+
+    measure("motionEnqueue (idle)", 1, [] { motionEnqueue(SPEED, PARTITION, 1); });
+    while (motionBusy()) { loop(); fakeAdvance(LOOP_PASS_US); }
+
+    FakePin &step = board.pins[STEP];
+    FakeTimer &timer = board.timers[HAL_TIMER_MOTION];
+    timer.latencyJitterUs = 2;      // Задержка входа в прерывание на плате, оценка
+    step.trace = true;
+    step.edgeTimes.clear();
+
+    uint32_t fires0 = timer.fires;
+    uint64_t t0 = fakeNow();
+    uint32_t passes = 0;
+    uint64_t worstPass = 0;
+    motionEnqueue(SPEED, PARTITION, 1);
+    while (motionBusy()) {
+        uint64_t p0 = fakeNow();
+        loop();
+        fakeAdvance(LOOP_PASS_US);
+        uint64_t pass = fakeNow() - p0;
+        if (pass > worstPass) worstPass = pass;
+        passes++;
+    }
+    uint64_t elapsed = fakeNow() - t0;
+    uint32_t fires = timer.fires - fires0;
+
+    // Отклонение интервалов между фронтами STEP от полупериода по таблице:
+    // интервал перед фронтом i — половина шага i / 2
+    double sum = 0, sum2 = 0, worst = 0;
+    size_t n = 0;
+    for (size_t i = 1; i < step.edgeTimes.size(); i++) {
+        double dev = (double)(step.edgeTimes[i] - step.edgeTimes[i - 1]) -
+                     motionHalfPeriod(SPEED, PARTITION, (uint16_t)(i / 2));
+        sum += dev;
+        sum2 += dev * dev;
+        if (fabs(dev) > worst) worst = fabs(dev);
+        n++;
+    }
+    step.trace = false;
+    timer.latencyJitterUs = 0;
+
+    // Стоимость одного прерывания генератора на Cortex-M3, оценка
+    const double isrCycles = 120;
+    printf("portion: %u steps in %.1f ms (constant 200 us half-period took %.1f ms)\n",
+           PARTITION, elapsed / 1000.0, 2.0 * 200 * PARTITION / 1000.0);
+    printf("loop passes during motion: %u, worst pass %llu us\n",
+           passes, (unsigned long long)worstPass);
+    printf("STEP edges: %zu, jitter mean %.2f us, rms %.2f us, worst %.0f us\n",
+           n + 1, n ? sum / n : 0.0, n ? sqrt(sum2 / n) : 0.0, worst);
+    verify(n + 1 == 2u * PARTITION, "portion made a different number of STEP edges");
+    verify(worst <= 2, "STEP edges jitter more than the interrupt entry latency");
+    verify(elapsed < 2ULL * 200 * PARTITION, "ramped portion is not faster than the constant 200 us half-period");
+    printf("timer isr: %u calls, %.0f/s, cpu share %.2f%% at %.0f cycles/isr\n",
+           fires, fires * 1e6 / elapsed,
+           100.0 * fires * isrCycles / (F_CPU_HOST / 1e6) / elapsed, isrCycles);
+
+    // Кривая скорости — на отдельной порции без дрожания входа в прерывание
+    step.trace = true;
+    step.edgeTimes.clear();
+    motionEnqueue(SPEED, PARTITION, 1);
+    while (motionBusy()) { loop(); fakeAdvance(LOOP_PASS_US); }
+    step.trace = false;
+    checkPulseTrain(step.edgeTimes, MOTION_PROFILE, PARTITION);
+    checkRampTables();
+}
+
+static size_t framesSeen = 0;
+static void countFrame(const Packet &) { framesSeen++; }
+
+// Глубина стека в обработчике кадра относительно вызывающего framerPoll()
+static const volatile char *stackBase = nullptr;
+static size_t stackDepth = 0;
+static void probeFrame(const Packet &) {
+    volatile char here = 0;
+    stackDepth = (size_t)(stackBase - &here);
+    framesSeen++;
+}
+
+// Кадр 0x06 из 132 байт, в котором каждые 3 байта начинается вложенный кадр,
+// и длины всех вложенных кадров указывают на один байт CRC в конце. Верна CRC
+// только самого внутреннего кадра: все внешние отбрасываются по очереди
+static std::vector<uint8_t> nestedFrames(uint8_t *outer) {
+    const uint8_t last = 3 + MAX_PAYLOAD_SIZE;      // Индекс общего байта CRC
+    std::vector<uint8_t> f(last + 1, 0);
+    uint8_t inner = 0;
+    for (uint8_t p = 0; p + 3 <= last; p += 3) {
+        f[p] = FRAME_SOF;
+        f[p + 1] = SYNC_UPLOAD;
+        f[p + 2] = last - p - 3;
+        inner = p;
+    }
+    *outer = inner / 3;
+    // Данные самого внутреннего кадра подбираются так, чтобы CRC внешних
+    // кадров не совпала с общим байтом
+    for (uint8_t fill = 0;; fill++) {
+        for (uint8_t i = inner + 3; i < last; i++) f[i] = fill + i;
+        f[last] = crc8(&f[inner + 1], last - inner - 1);
+        bool unique = true;
+        for (uint8_t p = 0; p < inner; p += 3) unique &= crc8(&f[p + 1], last - p - 1) != f[last];
+        if (unique) break;
+    }
+    return f;
+}
+
+// Поток кадров подряд, часть повреждена, между кадрами встречается мусор
+static void benchFramer() {
+    header("framer");
+
+    const int total = 20000;
+    std::vector<uint8_t> stream;
+    int good = 0;
+    uint32_t seed = 7;
+    for (int i = 0; i < total; i++) {
+        seed = seed * 1103515245 + 12345;
+        uint8_t payload[SHORT_PAYLOAD_SIZE];
+        uint8_t len = (seed >> 8) % (SHORT_PAYLOAD_SIZE + 1);
+        for (uint8_t k = 0; k < len; k++) payload[k] = (uint8_t)(seed >> (k % 3 * 8));
+        uint8_t frame[4 + MAX_PAYLOAD_SIZE];
+        size_t n = makeFrame((uint8_t)(i & 0x7F), payload, len, frame);
+        switch (i % 10) {
+            case 3: frame[n - 1] ^= 0x5A; break;                    // Испорченная CRC
+            case 6: frame[2] = SHORT_PAYLOAD_SIZE + 9; break;       // Испорченная длина
+            case 8: stream.push_back(0x13); stream.push_back(FRAME_SOF); good++; break;  // Мусор и ложное начало
+            default: good++;
+        }
+        stream.insert(stream.end(), frame, frame + n);
+    }
+
+    // Разбор на хосте: байты порциями по 48, как между проходами loop()
+    framesSeen = 0;
+    auto h0 = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < stream.size(); i += 48) {
+        for (size_t k = i; k < i + 48 && k < stream.size(); k++) framerPush(stream[k]);
+        framerPoll(countFrame);
+    }
+    auto h1 = std::chrono::steady_clock::now();
+    double ns = std::chrono::duration<double, std::nano>(h1 - h0).count();
+    const FramerStats &st = framerStats();
+    printf("%d frames, %zu bytes: %zu accepted (expected %d), crc err %u, len err %u, skipped %u bytes\n",
+           total, stream.size(), framesSeen, good, st.crcErrors, st.lenErrors, st.skipped);
+    printf("parse: %.1f ns/byte, %.1f ns/frame on host\n", ns / stream.size(), ns / total);
+    verify(framesSeen == (size_t)good, "framer accepted a different number of frames than were sent intact");
+
+    // Вложенные ложные кадры: разбор не должен углубляться в стек на каждом
+    uint8_t outer;
+    std::vector<uint8_t> nested = nestedFrames(&outer);
+    volatile char base = 0;
+    stackBase = &base;
+    framesSeen = 0;
+    uint32_t crc0 = framerStats().crcErrors;
+    for (size_t i = 0; i < nested.size(); i += 32) {
+        for (size_t k = i; k < i + 32 && k < nested.size(); k++) framerPush(nested[k]);
+        framerPoll(probeFrame);
+    }
+    printf("nested false frames: %zu B, %u rejected, %zu accepted, stack in handler %zu B\n", nested.size(),
+           framerStats().crcErrors - crc0, framesSeen, stackDepth);
+    verify(framesSeen == 1 && framerStats().crcErrors - crc0 == outer,
+           "nested false frames are not rejected one by one");
+    verify(stackDepth < 1024, "framer stack grows with nested false frames");
+
+    // Прерывание приёма у ядра: целый кадр 0x06 накоплен в буфере ядра до
+    // framerPoll() и длиннее буфера разбора — переносится частями без потерь
+    board.uart.coreRx = true;
+    uint8_t upload[4 + MAX_PAYLOAD_SIZE], data[MAX_PAYLOAD_SIZE];
+    for (uint8_t k = 0; k < MAX_PAYLOAD_SIZE; k++) data[k] = k;
+    size_t uploadLen = makeFrame(SYNC_UPLOAD, data, MAX_PAYLOAD_SIZE, upload);
+    board.uart.feed(upload, uploadLen);
+    fakeAdvance(uploadLen * board.uart.byteTimeUs());
+    size_t buffered = board.uart.rx.size();
+    uint32_t overflows0 = framerStats().overflows;
+    framesSeen = 0;
+    framerPoll(countFrame);
+    printf("0x06 frame of %zu B buffered by the core: %zu accepted in one poll, %u bytes lost\n", buffered,
+           framesSeen, framerStats().overflows - overflows0);
+    verify(buffered == uploadLen && framesSeen == 1 && framerStats().overflows == overflows0,
+           "0x06 frame buffered by the core loses bytes on the way to the framer");
+    board.uart.coreRx = false;
+
+    // Задержка от последнего байта кадра до обработчика при непрерывной работе loop()
+    double sumUs = 0, worstUs = 0;
+    const int rounds = 50;
+    for (int r = 0; r < rounds; r++) {
+        uint8_t frame[4 + MAX_PAYLOAD_SIZE];
+        uint8_t cmd = 0x7F;
+        size_t n = makeFrame(cmd, nullptr, 0, frame);
+        board.uart.feed(frame, n);
+        uint64_t arrived = fakeNow() + n * board.uart.byteTimeUs();
+        uint32_t before = framerStats().frames;
+        while (framerStats().frames == before) { loop(); fakeAdvance(LOOP_PASS_US); }
+        double us = (double)(fakeNow() - arrived);
+        sumUs += us;
+        if (us > worstUs) worstUs = us;
+    }
+    printf("frame -> handled latency: mean %.1f us, worst %.1f us (was up to 1000 ms)\n",
+           sumUs / rounds, worstUs);
+
+    // Пакеты Cat.aia без обрамления после паузы: добавить, время, список, запуск, удалить
+    fakeAdvance(BLE_SESSION_GAP_MS * 1000ULL);
+    // Каждый пакет — отдельная посылка, как SendBytes приложения
+    auto sendApp = [](std::vector<uint8_t> packet) {
+        board.uart.feed(packet.data(), packet.size());
+        for (int i = 0; i < 20000; i++) { loop(); fakeAdvance(LOOP_PASS_US); }
+    };
+    fakeAdvance(BLE_SESSION_GAP_MS * 1000ULL);
+    uint32_t legacy0 = framerStats().legacy;
+    sendApp({0x00, 3, 7, 45, 5});
+    sendApp({0x03, 6, 0, 30, 12, 15, 6, 25});
+    size_t tx0 = board.uart.tx.size();
+    sendApp({0x02, 0});
+    // Ответ 0x02 — как читает Cat.aia: часы и минуты шести задач
+    bool listOk = board.uart.tx.size() - tx0 == 2 * TASK_LIST_LEGACY;
+    for (int i = 0; listOk && i < TASK_LIST_LEGACY; i++) {
+        TaskEntry e = tasksGet(i);
+        uint8_t h = taskUsed(e) ? taskHours(e) : TASK_LIST_FREE, m = taskUsed(e) ? taskMinutes(e) : 0;
+        listOk = board.uart.tx[tx0 + 2 * i] == h && board.uart.tx[tx0 + 2 * i + 1] == m;
+    }
+    listOk = listOk && board.uart.tx[tx0 + 10] == 7 && board.uart.tx[tx0 + 11] == 45;
+    sendApp({0x04, 0});
+    TaskEntry added = tasksGet(5);
+    bool addedOk = taskUsed(added) && taskHours(added) == 7 && taskMinutes(added) == 45;
+    sendApp({0x01, 1, 5});
+    uint32_t accepted = framerStats().legacy - legacy0;
+    printf("Cat.aia packets without framing: %u of 5 accepted, task 5 added %s, removed %s\n", accepted,
+           addedOk ? "yes" : "no", taskUsed(tasksGet(5)) ? "no" : "yes");
+    verify(accepted == 5 && addedOk && !taskUsed(tasksGet(5)), "unframed Cat.aia packets are not handled");
+    verify(listOk, "0x02 reply is not 6 x (hours, minutes) as Cat.aia reads it");
+
+    // Пакет внутри потока мусора и байты команд после кадра 0xA5 — шум
+    fakeAdvance(BLE_SESSION_GAP_MS * 1000ULL);
+    sendApp({0x02, 0, 0x13});
+    sendApp({0x13, 0x02, 0});
+    feedPacket(0x7F, nullptr, 0);
+    readPacket();
+    sendApp({0x02, 0});
+    verify(framerStats().legacy - legacy0 == 5, "noise parsed as an unframed packet");
+    while (uartBusy()) { loop(); fakeAdvance(LOOP_PASS_US); }
+}
+
+// Сутки работы планировщика: транзакции I2C, пробуждения и точность кормлений
+static void runSchedDays(const char *name, int8_t intPin, int days) {
+    board.rtc.intPin = intPin;
+    schedBegin(intPin, feedTask);
+
+    const SchedStats before = schedStats();
+    uint32_t tx0 = board.bus.stats.transactions;
+    uint32_t fired = before.fired;
+    double lateSum = 0, lateWorst = 0;
+    uint64_t end = fakeNow() + days * 86400ULL * 1000000ULL;
+    while (fakeNow() < end) {
+        loop();
+        fakeAdvance(10000);     // Проход loop() раз в 10 мс виртуального времени
+        if (schedStats().fired != fired) {
+            fired = schedStats().fired;
+            double late = (double)(board.rtc.epoch() % 60);  // Кормления назначены на hh:mm:00
+            lateSum += late;
+            if (late > lateWorst) lateWorst = late;
+        }
+    }
+    const SchedStats &st = schedStats();
+    uint32_t feeds = st.fired - before.fired;
+    printf("%-26s %10.1f %10.1f %10.1f %8u %9.2f %8.0f\n", name,
+           (double)(board.bus.stats.transactions - tx0) / days,
+           (double)(st.wakeups - before.wakeups) / days,
+           (double)(st.recomputes - before.recomputes) / days,
+           feeds, feeds ? lateSum / feeds : 0.0, lateWorst);
+    while (motionBusy()) { loop(); fakeAdvance(LOOP_PASS_US); }
+}
+
+static void benchScheduler() {
+    printf("\n== scheduler (3 feedings/day, RTC drift 20 ppm)\n");
+    printf("%-26s %10s %10s %10s %8s %9s %8s\n",
+           "mode", "i2c tx/day", "wakes/day", "recomp/day", "feeds", "late s", "worst s");
+    printf("%-26s %10u %10u %10s %8s %9s %8s\n",
+           "per-second polling (old)", 86400u * 4, 86400u, "-", "-", "-", "-");
+
+    addTask(0, Time{8, 0});
+    addTask(1, Time{13, 0});
+    addTask(2, Time{20, 0});
+    board.rtc.driftPpm = 20;
+
+    runSchedDays("millis deadline", -1, 3);
+    runSchedDays("DS3231 alarm on INT", 2, 3);
+
+    board.rtc.driftPpm = 0;
+    board.rtc.intPin = -1;
+    schedBegin(RTC_INT, feedTask);
+}
+
+// Время часов и программных часов
+static void benchClock() {
+    header("clock");
+    measure("getTime (burst 0x00..0x02)", 1000, [] { Time t; getTime(t); });
+    measure("getDateTime (burst 0x00..0x06)", 1000, [] { DateTime dt; getDateTime(dt); });
+    measure("getHours + getMinutes (per reg)", 1000, [] { getHours(); getMinutes(); });
+    measure("clockEpoch", 100000, [] { clockEpoch(); });
+
+    // Разрыв на смене часа: чтение начинается за 0..999 мкс до 13:00:00
+    int tornOld = 0, tornNew = 0;
+    for (int i = 0; i < 1000; i++) {
+        board.rtc.setEpoch(12 * 3600 + 59 * 60 + 59);
+        fakeAdvance(999000 + i);
+        uint8_t h = getHours();
+        uint8_t m = getMinutes();
+        if (!((h == 12 && m == 59) || (h == 13 && m == 0))) tornOld++;
+        board.rtc.setEpoch(12 * 3600 + 59 * 60 + 59);
+        fakeAdvance(999000 + i);
+        Time t = {0, 0};
+        if (!getTime(t) || !((t.hours == 12 && t.minutes == 59) || (t.hours == 13 && t.minutes == 0))) tornNew++;
+    }
+    printf("torn reads at 12:59:59.999 -> 13:00: per-register %d/1000, burst %d/1000\n", tornOld, tornNew);
+    verify(tornNew == 0, "burst time read is torn at the hour boundary");
+
+    // Преобразование даты и обратно на случайных моментах 2000..2099
+    int epochErrors = 0;
+    uint32_t seed = 11;
+    for (int i = 0; i < 2000; i++) {
+        seed = seed * 1103515245 + 12345;
+        uint32_t e = seed % 3155760000UL;
+        board.rtc.setEpoch(e);
+        DateTime dt;
+        if (!getDateTime(dt) || toEpoch(dt) != (uint32_t)board.rtc.epoch()) epochErrors++;
+        if (toEpoch(fromEpoch(e)) != e) epochErrors++;
+    }
+    printf("epoch conversions: %d errors in 4000 checks\n", epochErrors);
+    verify(epochErrors == 0, "epoch conversion round trip");
+
+    // Программные часы против DS3231 с уходом 50 ppm за сутки
+    printf("%-18s %12s %12s %12s\n", "sync interval", "i2c tx/day", "mean err s", "worst err s");
+    const uint32_t intervals[] = {1000, 60000, CLOCK_SYNC_MS, 3600000};
+    for (uint32_t interval : intervals) {
+        board.rtc.setEpoch(9 * 86400 + 7 * 3600 + 123);
+        board.rtc.driftPpm = 50;
+        clockSetSyncInterval(interval);
+        clockSync();
+        clockSync();
+        uint32_t tx0 = board.bus.stats.transactions;
+        double errSum = 0, errWorst = 0;
+        int samples = 0;
+        for (uint64_t t = 0; t < 86400ULL * 1000000ULL; t += 97000) {
+            fakeAdvance(97000);
+            busPoll();
+            double err = fabs((double)clockEpoch() - (double)board.rtc.epoch());
+            errSum += err;
+            if (err > errWorst) errWorst = err;
+            samples++;
+        }
+        printf("%15u ms %12u %12.3f %12.0f\n", interval,
+               board.bus.stats.transactions - tx0, errSum / samples, errWorst);
+        // Программные часы отстают от DS3231 не больше чем на секунду округления
+        if (interval <= CLOCK_SYNC_MS) verify(errWorst <= 1, "software clock drifts more than 1 s between syncs");
+    }
+    board.rtc.driftPpm = 0;
+    clockSetSyncInterval(CLOCK_SYNC_MS);
+    clockSync();
+
+    // DS3231 не отвечает: сверка пропускается, программные часы идут дальше
+    board.rtc.setEpoch(9 * 86400 + 7 * 3600 + 123);
+    clockSync();
+    board.bus.attach(0x68, nullptr);
+    fakeAdvance(5000000);
+    bool synced = clockSync();
+    uint32_t epoch = clockEpoch();
+    Time t = {77, 77};
+    bool timeRead = getTime(t);
+    board.bus.attach(0x68, &board.rtc);
+    int64_t err = (int64_t)epoch - board.rtc.epoch();
+    printf("sync with DS3231 not answering: %s, software clock off by %lld s, getTime %s\n",
+           synced ? "applied" : "skipped", (long long)err, timeRead ? "returned a time" : "failed");
+    verify(!synced && err >= -1 && err <= 1, "failed RTC read is applied as a sync");
+    verify(!timeRead && t.hours == 77 && t.minutes == 77, "getTime returns a time the DS3231 did not send");
+    clockSync();
+}
+
+#define UNIX_2000 946684800LL       // 2000-01-01 00:00:00 в секундах Unix
+
+// Календарь и BCD против эталона: gmtime_r/timegm из libc и разбор BCD по
+// определению. Проверяется каждый день 2000..2099 (весь диапазон DS3231) со
+// случайной секундой суток и каждый байт регистров
+static void benchCalendar() {
+    header("calendar");
+    int errors = 0, checks = 0;
+    auto check = [&](bool ok) { checks++; if (!ok) errors++; };
+
+    uint32_t seed = 17;
+    const int32_t first = daysFromCivil(2000, 1, 1), last = daysFromCivil(2100, 1, 1);
+    for (int32_t d = first; d < last; d++) {
+        seed = seed * 1103515245 + 12345;
+        uint32_t sec = (seed >> 8) % 86400;
+        time_t t = (time_t)(UNIX_2000 + d * 86400LL + sec);
+        struct tm ref, next;
+        gmtime_r(&t, &ref);
+        time_t tn = t + 86400;
+        gmtime_r(&tn, &next);
+        uint8_t weekday = ref.tm_wday == 0 ? 7 : ref.tm_wday;
+
+        uint32_t epoch = (uint32_t)d * 86400UL + sec;
+        DateTime dt = fromEpoch(epoch);
+        check(dt.year == ref.tm_year + 1900 && dt.month == ref.tm_mon + 1 && dt.date == ref.tm_mday);
+        check(dt.hours == ref.tm_hour && dt.minutes == ref.tm_min && dt.seconds == ref.tm_sec);
+        check(dt.day == weekday);
+        check(toEpoch(dt) == epoch);
+        check(daysFromCivil(ref.tm_year + 1900, ref.tm_mon + 1, ref.tm_mday) == d);
+        check((int64_t)epochFromCivil(ref.tm_year + 1900, ref.tm_mon + 1, ref.tm_mday, ref.tm_hour, ref.tm_min,
+                                      ref.tm_sec) == (int64_t)timegm(&ref) - UNIX_2000);
+        check(secondOfWeek(epoch) == (weekday - 1) * 86400UL + sec);
+        check(minuteOfWeek(epoch) == ((weekday - 1) * 86400UL + sec) / 60);
+        if (next.tm_mday == 1) check(daysInMonth(ref.tm_year + 1900, ref.tm_mon + 1) == ref.tm_mday);
+    }
+    int rangeChecks = checks;
+
+    // За пределами DS3231: столетия 1900 и 2100 не високосные
+    for (int32_t d = daysFromCivil(1900, 1, 1); d < daysFromCivil(2200, 1, 1); d++) {
+        time_t t = (time_t)(UNIX_2000 + d * 86400LL);
+        struct tm ref;
+        gmtime_r(&t, &ref);
+        CivilDate c = civilFromDays(d);
+        check(c.year == ref.tm_year + 1900 && c.month == ref.tm_mon + 1 && c.day == ref.tm_mday);
+        check(daysFromCivil(c.year, c.month, c.day) == d);
+        check(weekdayFromDays(d) == (ref.tm_wday == 0 ? 7 : ref.tm_wday));
+    }
+
+    // Каждый байт BCD и каждое значение регистра часов в обоих режимах
+    for (int b = 0; b < 256; b++) {
+        bool valid = (b >> 4) < 10 && (b & 0xF) < 10;
+        check(bcdDecode(b) == (valid ? (b >> 4) * 10 + (b & 0xF) : BCD_INVALID));
+    }
+    for (int v = 0; v < 100; v++) check(bcdEncode(v) == (((v / 10) << 4) | (v % 10)));
+    for (int h = 0; h < 24; h++) {
+        check(bcdDecodeHours(bcdEncode(h)) == h);
+        int h12 = h % 12 == 0 ? 12 : h % 12;
+        check(bcdDecodeHours(BCD_HOURS_12 | (h >= 12 ? BCD_HOURS_PM : 0) | bcdEncode(h12)) == h);
+    }
+    // Неверный регистр часов остаётся неверным в обоих режимах (бит 7 всегда 0)
+    for (int r = 0; r < 0x80; r++) {
+        int tens = (r & BCD_HOURS_12) ? (r >> 4) & 1 : (r >> 4) & 3, units = r & 0xF, h = tens * 10 + units;
+        int expect = BCD_INVALID;
+        if ((r & BCD_HOURS_12) && units < 10 && h >= 1 && h <= 12) expect = h % 12 + ((r & BCD_HOURS_PM) ? 12 : 0);
+        if (!(r & BCD_HOURS_12) && units < 10 && h < 24) expect = h;
+        check(bcdDecodeHours(r) == expect);
+    }
+
+    // setTime и чтение обратно через шину: полдень первого числа каждого месяца
+    int busErrors = 0;
+    for (int y = 2000; y < 2100; y++) {
+        for (int m = 1; m <= 12; m++) {
+            setTime(30, 0, 12, 1, m, y);
+            DateTime dt = {};
+            if (!getDateTime(dt) || dt.year != y || dt.month != m || dt.date != 1 || dt.hours != 12 ||
+                dt.day != weekdayFromDays(daysFromCivil(y, m, 1))) busErrors++;
+        }
+    }
+    printf("%d days 2000..2099: %d checks, 1900..2199 and BCD: %d checks, %d errors; "
+           "setTime round trip %d errors in 1200 months\n",
+           last - first, rangeChecks, checks - rangeChecks, errors, busErrors);
+    verify(errors == 0, "calendar or BCD disagrees with the reference");
+    verify(busErrors == 0, "setTime does not read back through the bus");
+
+    volatile uint32_t sink = 0;
+    measure("fromEpoch", 100000, [&] { seed = seed * 1103515245 + 12345; sink = fromEpoch(seed % 3155760000UL).day; });
+    measure("toEpoch", 100000, [&] { seed = seed * 1103515245 + 12345;
+                                     sink = toEpoch(DateTime{0, 0, 0, 1, (uint8_t)(seed % 28 + 1), (uint8_t)((seed >> 8) % 12 + 1),
+                                                             (uint16_t)(2000 + (seed >> 16) % 100)}); });
+    (void)sink;
+    clockSync();
+}
+
+// Годы правок расписания: износ ячеек EEPROM и худшее время сохранения
+static void benchStore() {
+    header("store");
+
+    const int days = 5 * 365;
+    const int editsPerDay = 4;
+    busFlush();
+    fakeReset();
+    setup();
+    FakeEeprom &ee = board.eeprom;
+    std::fill(ee.cellWrites.begin(), ee.cellWrites.end(), 0);
+    uint32_t pages0 = ee.pageWrites;
+
+    double sumUs = 0, worstUs = 0;
+    uint32_t tx = 0;
+    uint32_t seed = 5;
+    for (int d = 0; d < days; d++) {
+        for (int e = 0; e < editsPerDay; e++) {
+            seed = seed * 1103515245 + 12345;
+            uint8_t slot = (seed >> 8) % MAX_TASK;
+            uint32_t tx0 = board.bus.stats.transactions;
+            uint64_t t0 = fakeNow();
+            if ((seed >> 20) % 4 == 0) removeTask(slot);
+            else addTask(slot, Time{(uint8_t)((seed >> 12) % 24), (uint8_t)((seed >> 16) % 60)});
+            busFlush();         // До подтверждения записи в EEPROM
+            double us = (double)(fakeNow() - t0);
+            sumUs += us;
+            if (us > worstUs) worstUs = us;
+            tx += board.bus.stats.transactions - tx0;
+            fakeAdvance(6000);  // Правки приходят не чаще, чем раз в несколько миллисекунд
+        }
+    }
+    int edits = days * editsPerDay;
+    uint32_t worstCell = *std::max_element(ee.cellWrites.begin(), ee.cellWrites.end());
+    const StoreStats &st = storeStats();
+    printf("%d edits over %d days: %u page writes, %u appends, %u checkpoints, %u unchanged\n",
+           edits, days, ee.pageWrites - pages0, st.appends, st.checkpoints, st.skipped);
+    printf("worst cell: %u writes (full image rewrite: %d), endurance 1e6 -> %.0f years\n",
+           worstCell, edits, 1e6 / worstCell * days / 365.0);
+    printf("save: mean %.0f us, worst %.0f us, %.2f i2c tx/edit (was 1 page + delay(5) = 6900 us)\n",
+           sumUs / edits, worstUs, (double)tx / edits);
+    verify(worstCell * 10 < (uint32_t)edits, "journal spreads EEPROM wear");
+
+    // Загрузка после перезапуска восстанавливает те же задачи
+    TaskEntry saved[MAX_TASK];
+    for (int i = 0; i < MAX_TASK; i++) saved[i] = tasksGet(i);
+    uint64_t t0 = fakeNow();
+    uint32_t tx0 = board.bus.stats.transactions;
+    setup();
+    int mismatches = 0;
+    for (int i = 0; i < MAX_TASK; i++) {
+        if (saved[i] != tasksGet(i)) mismatches++;
+    }
+    printf("reboot: %d mismatched tasks, setup %.1f ms, %u i2c tx\n",
+           mismatches, (fakeNow() - t0) / 1000.0, board.bus.stats.transactions - tx0);
+    verify(mismatches == 0, "store reload restores every task");
+
+    // Пачка из 40 ключей: записи журнала идут по две на страницу EEPROM,
+    // в очереди шины не больше одной страницы пачки
+    storeCheckpoint();
+    while (!busIdle() || storeBusy()) { loop(); fakeAdvance(LOOP_PASS_US); }
+    const int batch = 40;
+    uint32_t pages1 = ee.pageWrites, rejected0 = busStats().rejected;
+    storeBeginBatch();
+    for (int k = 0; k < batch; k++) storeSet(k, storeGet(k) ^ 0x10000);
+    storeEndBatch();
+    uint8_t queued = BUS_QUEUE - busFree();
+    while (!busIdle() || storeBusy()) { loop(); fakeAdvance(LOOP_PASS_US); }
+    uint32_t batchPages = ee.pageWrites - pages1;
+    printf("batch of %d keys: %u page writes, %u bus jobs queued at once\n", batch, batchPages, queued);
+    verify(batchPages == batch * STORE_RECORD / EEPROM_PAGE, "journal batch is written page by page");
+    verify(queued == 1, "journal batch keeps one page in the bus queue");
+
+    // Очередь шины заполнена: storeSet() не ждёт, страница повторяется из loop()
+    uint8_t reg = 0x00;
+    while (busRead(0x68, &reg, 1, 1, false, nullptr) != BUS_FULL) {}
+    uint64_t t1 = fakeNow();
+    uint32_t expect = storeGet(batch) ^ 0x10000;
+    storeSet(batch, expect);
+    bool waited = fakeNow() != t1;
+    while (!busIdle() || storeBusy()) { loop(); fakeAdvance(LOOP_PASS_US); }
+    uint32_t rejected = busStats().rejected - rejected0;
+    storeBegin(nullptr, 0);
+    printf("full bus queue: storeSet %s, %u posts rejected, value %s after reload\n",
+           waited ? "waited" : "returned at once", rejected, storeGet(batch) == expect ? "kept" : "LOST");
+    verify(!waited, "storeSet does not wait for a full bus queue");
+    verify(rejected > 0, "full bus queue rejects the journal page");
+    verify(storeGet(batch) == expect, "rejected journal page is retried from loop()");
+}
+
+// Поколение копии образа по заголовку в памяти EEPROM; -1 — заголовка нет
+static int imageGeneration(uint16_t addr) {
+    const std::vector<uint8_t> &m = board.eeprom.mem;
+    if (m[addr] != 'F' || m[addr + 1] != 'D') return -1;
+    return m[addr + 4] | (m[addr + 5] << 8);
+}
+
+// Порча одного байта записей копии образа: CRC не сойдётся
+static void corruptImage(uint16_t addr) {
+    board.eeprom.mem[addr + 8 + 5] ^= 0x40;
+}
+
+// Перезапуск: время от начала setup() до готовности к кормлению, проверка
+// таблицы задач и того, что время в DS3231 не перезаписано без нужды
+static void runBoot(const char *name, const std::vector<TaskEntry> &expect) {
+    fakeAdvance(100000);        // Питание выключено: циклы записи EEPROM закончились
+    bool lost = board.rtc.oscillatorStopped();
+    int64_t rtc0 = board.rtc.epoch();
+    uint64_t t0 = fakeNow();
+    uint32_t tx0 = board.bus.stats.transactions, bytes0 = board.bus.stats.bytes;
+    setup();
+    double ms = (fakeNow() - t0) / 1000.0;
+    uint32_t tx = board.bus.stats.transactions - tx0, bytes = board.bus.stats.bytes - bytes0;
+    int64_t drift = board.rtc.epoch() - rtc0 - (int64_t)((fakeNow() - t0) / 1000000);
+
+    int mismatches = 0;
+    for (int i = 0; i < MAX_TASK; i++) if (tasksGet(i) != expect[i]) mismatches++;
+    printf("%-30s %8.1f %6u %7u %6u %5u %5s %5s %4u\n", name, ms, tx, bytes, tasksUsed(),
+           storeStats().generation, lost ? "yes" : "no", (drift < -1 || drift > 1) ? "set" : "kept",
+           mismatches);
+
+    verify(mismatches == 0, "boot restores the saved tasks");
+    verify(lost == (drift < -1 || drift > 1), "boot sets the RTC only after it lost time");
+
+    while (!busIdle() || storeBusy()) { loop(); fakeAdvance(LOOP_PASS_US); }
+    bool osf = board.rtc.oscillatorStopped();
+    if (osf) printf("  OSF still set after boot\n");
+    verify(!osf, "boot clears OSF");
+}
+
+static std::vector<TaskEntry> currentTasks() {
+    std::vector<TaskEntry> t(MAX_TASK);
+    for (int i = 0; i < MAX_TASK; i++) t[i] = tasksGet(i);
+    return t;
+}
+
+// Холодный старт в разных состояниях EEPROM и DS3231
+static void benchBoot() {
+    printf("\n== boot (setup() to ready to feed; was %s)\n",
+           "storeBegin 211.7 ms at 100 kHz, RTC overwritten with build time on every reset");
+    printf("%-30s %8s %6s %7s %6s %5s %5s %5s %4s\n",
+           "state", "ms", "i2c tx", "i2c B", "tasks", "gen", "OSF", "clock", "bad");
+
+    busFlush();
+    fakeReset();
+    std::vector<TaskEntry> defaults(MAX_TASK, TASK_FREE);
+    defaults[0] = taskMake(8, 0);
+    defaults[1] = taskMake(13, 0);
+    defaults[2] = taskMake(20, 0);
+    runBoot("first power-on, blank EEPROM", defaults);
+
+    // Расписание из 64 задач сохранено в образ, журнал пуст
+    board.rtc.setEpoch(9 * 86400 + 7 * 3600 + 123);
+    uint32_t seed = 21;
+    for (int i = 0; i < 64; i++) {
+        seed = seed * 1103515245 + 12345;
+        addTask(i * 4, Time{(uint8_t)((seed >> 8) % 24), (uint8_t)((seed >> 16) % 60)});
+    }
+    storeCheckpoint();
+    while (!busIdle() || storeBusy()) { loop(); fakeAdvance(LOOP_PASS_US); }
+    std::vector<TaskEntry> saved = currentTasks();
+    runBoot("reset, image + empty journal", saved);
+
+    // Правки в журнале почти до конца поколения
+    while (storeStats().journalUsed + 2 < STORE_JOURNAL_RECORDS) {
+        seed = seed * 1103515245 + 12345;
+        addTask((seed >> 8) % MAX_TASK, Time{(uint8_t)((seed >> 12) % 24), (uint8_t)((seed >> 16) % 60)});
+        busFlush();
+    }
+    saved = currentTasks();
+    runBoot("reset, full journal", saved);
+
+    // Новая копия образа испорчена: берётся прежняя и её журнал
+    storeCheckpoint();
+    while (!busIdle() || storeBusy()) { loop(); fakeAdvance(LOOP_PASS_US); }
+    saved = currentTasks();
+    uint16_t newer = imageGeneration(STORE_IMAGE_A) > imageGeneration(STORE_IMAGE_B) ? STORE_IMAGE_A : STORE_IMAGE_B;
+    corruptImage(newer);
+    runBoot("reset, newest image corrupt", saved);
+
+    // Испорчены обе копии (испорченную новую загрузка уже переписала): задачи по умолчанию
+    corruptImage(STORE_IMAGE_A);
+    corruptImage(STORE_IMAGE_B);
+    runBoot("reset, both images corrupt", defaults);
+
+    // Батарея часов села при выключенном питании
+    board.rtc.stopOscillator();
+    runBoot("reset, RTC oscillator stopped", defaults);
+
+    // Новая копия испорчена, когда в её журнале уже были правки: берётся
+    // прежняя копия, и записи журнала испорченного поколения не возвращаются
+    // ни после нового сохранения, ни после новых правок
+    storeCheckpoint();
+    while (!busIdle() || storeBusy()) { loop(); fakeAdvance(LOOP_PASS_US); }
+    std::vector<TaskEntry> before = currentTasks();
+    addTask(50, Time{5, 55});
+    for (int i = 100; i < 109; i++) {
+        busFlush();
+        addTask(i, Time{(uint8_t)(i % 24), 30});
+    }
+    busFlush();
+    newer = imageGeneration(STORE_IMAGE_A) > imageGeneration(STORE_IMAGE_B) ? STORE_IMAGE_A : STORE_IMAGE_B;
+    corruptImage(newer);
+    runBoot("reset, corrupt image had edits", before);
+    storeCheckpoint();
+    while (!busIdle() || storeBusy()) { loop(); fakeAdvance(LOOP_PASS_US); }
+    for (int i = 10; i < 15; i++) {
+        addTask(i, Time{6, (uint8_t)i});
+        busFlush();             // Задача и версия расписания — две записи журнала
+    }
+    saved = currentTasks();
+    runBoot("reset, edits after fallback", saved);
+    verify(storeStats().journalUsed == 10, "journal of the corrupt generation is replayed again");
+}
+
+// Ближайшее срабатывание перебором всех задач и дней — для проверки индекса
+static uint32_t nextDueScan(uint32_t now) {
+    const uint32_t week = WEEK_MINUTES * 60UL;
+    uint32_t best = UINT32_MAX;
+    for (uint16_t i = 0; i < MAX_TASK; i++) {
+        TaskEntry e = tasksGet(i);
+        if (!taskUsed(e)) continue;
+        for (uint8_t day = 0; day < 7; day++) {
+            if (!(taskDays(e) & (1 << day))) continue;
+            uint32_t d = ((day * 1440UL + taskMinute(e)) * 60 + week - now) % week;
+            if (d == 0) d = week;
+            if (d < best) best = d;
+        }
+    }
+    return best;
+}
+
+// То же по индексу, как в планировщике
+static uint32_t nextDueIndex(uint32_t now) {
+    const uint32_t week = WEEK_MINUTES * 60UL;
+    if (tasksIndexSize() == 0) return UINT32_MAX;
+    uint16_t k = tasksFind((now / 60 + 1) % WEEK_MINUTES);
+    if (k == tasksIndexSize()) k = 0;
+    uint32_t d = (tasksMinuteAt(k) * 60UL + week - now) % week;
+    return d == 0 ? week : d;
+}
+
+// Полная таблица: случайные дни недели, время и порции
+static void benchTasks() {
+    header("tasks");
+    busFlush();
+    fakeReset();
+    setup();
+
+    uint32_t seed = 3;
+    auto rnd = [&] { seed = seed * 1103515245 + 12345; return seed >> 8; };
+    uint32_t occurrences = 0;
+    for (uint16_t i = 0; i < MAX_TASK; i++) {
+        uint8_t days = rnd() % 127 + 1;
+        tasksSet(i, taskMake(rnd() % 24, rnd() % 60, days, rnd() % 3 + 1));
+        occurrences += __builtin_popcount(days);
+    }
+    busFlush();
+
+    static uint16_t slot = 0;
+    measure("tasksSet (index update)", 1000,
+            [] { busFlush(); },
+            [] { slot = (slot + 37) % MAX_TASK;
+                 TaskEntry e = tasksGet(slot);
+                 tasksSet(slot, taskMake(taskHours(e), (taskMinutes(e) + 1) % 60, taskDays(e), taskPortions(e))); });
+    busFlush();
+    measure("tasksBegin (index rebuild)", 100, [] { tasksBegin(); });
+
+    // Ближайшее срабатывание: индекс против перебора на случайных моментах недели
+    const int queries = 100000;
+    std::vector<uint32_t> at(queries);
+    for (auto &t : at) t = rnd() % (WEEK_MINUTES * 60UL);
+    int errors = 0;
+    for (uint32_t t : at) if (nextDueIndex(t) != nextDueScan(t)) errors++;
+    volatile uint32_t sink = 0;
+    auto h0 = std::chrono::steady_clock::now();
+    for (uint32_t t : at) sink = sink + nextDueIndex(t);
+    auto h1 = std::chrono::steady_clock::now();
+    for (uint32_t t : at) sink = sink + nextDueScan(t);
+    auto h2 = std::chrono::steady_clock::now();
+    printf("%u entries, %u weekly occurrences: next-due %d mismatches in %d\n",
+           tasksUsed(), tasksIndexSize(), errors, queries);
+    printf("next-due: index %.0f ns, linear scan %.0f ns on host\n",
+           std::chrono::duration<double, std::nano>(h1 - h0).count() / queries,
+           std::chrono::duration<double, std::nano>(h2 - h1).count() / queries);
+
+    // Неделя работы планировщика: каждое срабатывание выполняется ровно один раз
+    board.rtc.setEpoch(2 * 86400);          // Понедельник, 2000-01-03 00:00:00
+    schedTimeChanged();
+    uint32_t fired0 = schedStats().fired;
+    uint64_t end = fakeNow() + 7 * 86400ULL * 1000000ULL;
+    while (fakeNow() < end) {
+        loop();
+        fakeAdvance(250000);
+    }
+    printf("one week: %u feedings fired, %u expected\n", schedStats().fired - fired0, occurrences);
+    while (motionBusy()) { loop(); fakeAdvance(LOOP_PASS_US); }
+
+    printf("per entry: %zu B table (RAM and each EEPROM image) + %zu B index per weekday, %d B journal per edit\n",
+           sizeof(TaskEntry), sizeof(uint16_t) + sizeof(uint8_t), STORE_RECORD);
+    printf("%d entries: RAM %zu B table + %zu B index, EEPROM 2 x %d B images + %d B journal\n",
+           MAX_TASK, MAX_TASK * sizeof(TaskEntry), TASK_INDEX * (sizeof(uint16_t) + sizeof(uint8_t)),
+           STORE_IMAGE_SIZE, STORE_JOURNAL_SIZE);
+}
+
+// Кадры ответа устройства в board.uart.tx начиная с from
+struct Reply {
+    uint8_t cmd;
+    std::vector<uint8_t> payload;
+};
+
+static std::vector<Reply> parseReplies(size_t from) {
+    std::vector<Reply> out;
+    const std::vector<uint8_t> &tx = board.uart.tx;
+    size_t i = from;
+    while (i + 4 <= tx.size()) {
+        if (tx[i] != FRAME_SOF) { i++; continue; }
+        uint8_t len = tx[i + 2];
+        if (i + 4 + len > tx.size()) break;
+        if (crc8(&tx[i + 1], 2 + len) == tx[i + 3 + len]) {
+            out.push_back(Reply{tx[i + 1], std::vector<uint8_t>(&tx[i + 3], &tx[i + 3 + len])});
+            i += 4 + len;
+        } else {
+            i++;
+        }
+    }
+    return out;
+}
+
+// Обмен с приложением: время передачи, ответа и записи в EEPROM
+struct Exchange {
+    size_t up = 0, down = 0;        // Байты на линии в обе стороны
+    double replyMs = 0;             // От последнего принятого байта до конца ответа
+    double persistMs = 0;           // От последнего принятого байта до окончания записи
+    double totalMs = 0;             // От первого переданного байта до конца ответа
+    uint32_t pages = 0;
+    std::vector<Reply> replies;
+};
+
+// Передать кадры подряд и работать, пока не придёт последний кадр ответа replyCmd
+static Exchange exchange(const std::vector<std::vector<uint8_t>> &frames, uint8_t replyCmd) {
+    Exchange x;
+    size_t txFrom = board.uart.tx.size();
+    uint32_t pages0 = board.eeprom.pageWrites;
+    uint64_t start = fakeNow();
+    for (const auto &f : frames) {
+        board.uart.feed(f.data(), f.size());
+        x.up += f.size();
+    }
+    uint64_t received = start + x.up * board.uart.byteTimeUs();
+
+    for (;;) {
+        loop();
+        fakeAdvance(LOOP_PASS_US);
+        x.replies = parseReplies(txFrom);
+        bool done = replyCmd == 0 ? fakeNow() > received : false;
+        for (const Reply &r : x.replies) {
+            if (r.cmd != replyCmd) continue;
+            if (replyCmd != (SYNC_DOWNLOAD | SYNC_REPLY) || (r.payload[2] & SYNC_LAST)) done = true;
+        }
+        if (done) break;
+    }
+    x.replyMs = (fakeNow() - received) / 1000.0;
+    x.totalMs = (fakeNow() - start) / 1000.0;
+    while (!busIdle() || storeBusy()) { loop(); fakeAdvance(LOOP_PASS_US); }
+    x.persistMs = (fakeNow() - received) / 1000.0;
+    x.down = board.uart.tx.size() - txFrom;
+    x.pages = board.eeprom.pageWrites - pages0;
+    return x;
+}
+
+static std::vector<uint8_t> frameOf(uint8_t cmd, const uint8_t *payload, uint8_t len) {
+    uint8_t buf[4 + MAX_PAYLOAD_SIZE];
+    size_t n = makeFrame(cmd, payload, len, buf);
+    return std::vector<uint8_t>(buf, buf + n);
+}
+
+// Загрузка записей (номер, задача) частями по SYNC_PER_FRAME
+static std::vector<std::vector<uint8_t>> uploadFrames(uint16_t base, bool full,
+                                                      const std::vector<std::pair<uint8_t, TaskEntry>> &recs) {
+    std::vector<std::vector<uint8_t>> frames;
+    size_t parts = recs.empty() ? 1 : (recs.size() + SYNC_PER_FRAME - 1) / SYNC_PER_FRAME;
+    for (size_t p = 0; p < parts; p++) {
+        uint8_t payload[MAX_PAYLOAD_SIZE] = {(uint8_t)(base & 0xFF), (uint8_t)(base >> 8),
+                                             (uint8_t)(p | (full ? SYNC_FULL : 0) | (p + 1 == parts ? SYNC_LAST : 0))};
+        uint8_t len = SYNC_HEADER;
+        for (size_t k = p * SYNC_PER_FRAME; k < recs.size() && k < (p + 1) * SYNC_PER_FRAME; k++) {
+            uint8_t *r = payload + len;
+            r[0] = recs[k].first;
+            for (int b = 0; b < 4; b++) r[1 + b] = recs[k].second >> (8 * b);
+            len += SYNC_RECORD;
+        }
+        frames.push_back(frameOf(SYNC_UPLOAD, payload, len));
+    }
+    return frames;
+}
+
+static std::vector<std::vector<uint8_t>> downloadFrames(uint16_t since, bool full) {
+    uint8_t payload[3] = {(uint8_t)(since & 0xFF), (uint8_t)(since >> 8), (uint8_t)(full ? SYNC_FULL : 0)};
+    return {frameOf(SYNC_DOWNLOAD, payload, sizeof(payload))};
+}
+
+// Записи, полученные выгрузкой
+static size_t downloadedRecords(const Exchange &x) {
+    size_t n = 0;
+    for (const Reply &r : x.replies) {
+        if (r.cmd == (SYNC_DOWNLOAD | SYNC_REPLY)) n += (r.payload.size() - SYNC_HEADER) / SYNC_RECORD;
+    }
+    return n;
+}
+
+static uint16_t replyVersion(const Exchange &x) {
+    for (const Reply &r : x.replies) {
+        if (r.cmd == (SYNC_UPLOAD | SYNC_REPLY)) return r.payload[1] | (r.payload[2] << 8);
+        if (r.cmd == (SYNC_DOWNLOAD | SYNC_REPLY)) return r.payload[0] | (r.payload[1] << 8);
+    }
+    return 0xFFFF;
+}
+
+static uint8_t replyStatus(const Exchange &x) {
+    for (const Reply &r : x.replies) {
+        if (r.cmd == (SYNC_UPLOAD | SYNC_REPLY)) return r.payload[0];
+    }
+    return 0xFF;
+}
+
+static void printExchange(const char *name, const Exchange &x, size_t records, int trips) {
+    printf("%-30s %7zu %6zu %6zu %9.1f %9.1f %10.1f %6u %5d\n", name, records, x.up, x.down,
+           x.totalMs, x.replyMs, x.persistMs, x.pages, trips);
+}
+
+// Кормление в 08:00:00, к которому приходит запрос 0x05 всей таблицы из tasks задач:
+// от установки часов на 07:59:59 до выполнения, мс
+static double feedingAtMs(int tasks, bool download) {
+    busFlush();
+    fakeReset();
+    setup();
+    for (int i = 1; i < tasks; i++) {
+        addTask(i, Time{(uint8_t)(12 + i % 10), (uint8_t)(i % 60)});
+        busFlush();
+    }
+    addTask(0, Time{8, 0});
+    while (!busIdle() || storeBusy()) { loop(); fakeAdvance(LOOP_PASS_US); }
+
+    board.rtc.setEpoch((board.rtc.epoch() / 86400 + 1) * 86400 + 8 * 3600 - 1);
+    uint64_t set = fakeNow(), due = set + 1000000;
+    schedTimeChanged();
+    if (download) {
+        // Последний байт запроса приходит за 2 мс до срока
+        uint8_t since[3] = {0, 0, SYNC_FULL}, frame[8];
+        size_t n = makeFrame(SYNC_DOWNLOAD, since, 3, frame);
+        board.uart.feed(frame, n, due - 2000 - n * board.uart.byteTimeUs());
+    }
+    uint32_t fired = schedStats().fired;
+    while (schedStats().fired == fired && fakeNow() < due + 5000000) { loop(); fakeAdvance(LOOP_PASS_US); }
+    double at = (fakeNow() - set) / 1000.0;
+    while (!busIdle() || storeBusy() || uartBusy() || motionBusy()) { loop(); fakeAdvance(LOOP_PASS_US); }
+    return at;
+}
+
+// Синхронизация расписания на согласованной скорости BLE: полная и по изменениям против пакетов 0x00
+static void benchSync() {
+    busFlush();
+    fakeReset();
+    setup();
+    printf("\n== sync (%d entries, %u baud)\n", MAX_TASK, bleBaud());
+    printf("%-30s %7s %6s %6s %9s %9s %10s %6s %5s\n",
+           "exchange", "records", "up B", "down B", "total ms", "reply ms", "persist ms", "pages", "trips");
+    while (!busIdle() || storeBusy()) { loop(); fakeAdvance(LOOP_PASS_US); }
+
+    uint32_t seed = 9;
+    auto rnd = [&] { seed = seed * 1103515245 + 12345; return seed >> 8; };
+    std::vector<std::pair<uint8_t, TaskEntry>> table;
+    for (int i = 0; i < MAX_TASK; i++) {
+        table.push_back({(uint8_t)i, taskMake(rnd() % 24, rnd() % 60, rnd() % 127 + 1, rnd() % 3 + 1)});
+    }
+
+    // Как раньше: по кадру 0x00 на задачу, каждый — отдельное изменение
+    std::vector<std::vector<uint8_t>> adds;
+    for (const auto &r : table) {
+        uint8_t p[5] = {taskHours(r.second), taskMinutes(r.second), r.first,
+                        taskDays(r.second), taskPortions(r.second)};
+        adds.push_back(frameOf(0x00, p, sizeof(p)));
+    }
+    uint32_t commits0 = storeStats().commits + storeStats().checkpoints;
+    Exchange perTask = exchange(adds, 0);
+    printExchange("0x00 per task (old)", perTask, table.size(), (int)table.size());
+    printf("  %u store commits/checkpoints\n", storeStats().commits + storeStats().checkpoints - commits0);
+
+    // Та же таблица одной загрузкой
+    for (auto &r : table) r.second = taskMake(taskHours(r.second), (taskMinutes(r.second) + 1) % 60,
+                                              taskDays(r.second), taskPortions(r.second));
+    commits0 = storeStats().commits + storeStats().checkpoints;
+    Exchange full = exchange(uploadFrames(tasksVersion(), true, table), SYNC_UPLOAD | SYNC_REPLY);
+    printExchange("0x06 full upload", full, table.size(), 1);
+    printf("  status %u, version %u, %u store commits/checkpoints\n", replyStatus(full), replyVersion(full),
+           storeStats().commits + storeStats().checkpoints - commits0);
+
+    // Приложение держит копию на версии v0 и меняет 5 задач
+    uint16_t v0 = tasksVersion();
+    std::vector<std::pair<uint8_t, TaskEntry>> diff;
+    for (int k = 0; k < 5; k++) {
+        uint8_t i = rnd() % MAX_TASK;
+        diff.push_back({i, k == 4 ? TASK_FREE : taskMake(rnd() % 24, rnd() % 60, TASK_EVERY_DAY, 2)});
+    }
+    commits0 = storeStats().commits + storeStats().checkpoints;
+    Exchange inc = exchange(uploadFrames(v0, false, diff), SYNC_UPLOAD | SYNC_REPLY);
+    printExchange("0x06 upload of 5 changes", inc, diff.size(), 1);
+    printf("  status %u, version %u, %u store commits/checkpoints\n", replyStatus(inc), replyVersion(inc),
+           storeStats().commits + storeStats().checkpoints - commits0);
+
+    Exchange stale = exchange(uploadFrames(v0, false, diff), SYNC_UPLOAD | SYNC_REPLY);
+    printExchange("0x06 upload on stale version", stale, diff.size(), 1);
+    printf("  status %u (conflict = %d)\n", replyStatus(stale), SYNC_CONFLICT);
+    verify(replyStatus(full) == SYNC_OK && replyStatus(inc) == SYNC_OK, "sync upload was not applied");
+    verify(replyStatus(stale) == SYNC_CONFLICT, "upload on a stale version was not rejected");
+
+    // Неверная запись отклоняет всю загрузку: верная запись рядом с ней не применяется
+    const TaskEntry bad[] = {
+        (TaskEntry)(24 * 60) | ((TaskEntry)TASK_EVERY_DAY << 11) | ((TaskEntry)1 << 18), // Минута за пределами суток
+        taskMake(8, 0) & ~((TaskEntry)0x0F << 18),                                     // Без порций
+        taskMake(8, 0) | ((TaskEntry)1 << 25),                                         // Бит резерва
+        taskMake(8, 0, TASK_EVERY_DAY, 1, MOTION_CHANNELS),                            // Канал без двигателя
+        (TaskEntry)(8 * 60) | ((TaskEntry)1 << 18),                                    // Без дней, но не свободна
+    };
+    int rejected = 0;
+    for (TaskEntry e : bad) {
+        uint16_t v = tasksVersion();
+        uint8_t slot = diff[0].first;
+        TaskEntry before = tasksGet(slot);
+        std::vector<std::pair<uint8_t, TaskEntry>> recs = {{slot, taskMake(5, 5)}, {(uint8_t)(slot + 1), e}};
+        Exchange x = exchange(uploadFrames(v, false, recs), SYNC_UPLOAD | SYNC_REPLY);
+        if (replyStatus(x) == SYNC_INVALID && tasksVersion() == v && tasksGet(slot) == before) rejected++;
+    }
+    printf("0x06 uploads with an invalid record: %d of %zu rejected whole (status %d)\n",
+           rejected, sizeof(bad) / sizeof(bad[0]), SYNC_INVALID);
+    verify(rejected == (int)(sizeof(bad) / sizeof(bad[0])), "upload with an invalid record was applied");
+
+    // Та же проверка у команды 0x00: канал без двигателя не меняет задачу
+    int addRejected = 0;
+    for (uint8_t channel : {(uint8_t)MOTION_CHANNELS, (uint8_t)(MOTION_CHANNELS + 8)}) {
+        uint16_t v = tasksVersion();
+        uint8_t slot = diff[0].first;
+        TaskEntry before = tasksGet(slot);
+        Packet add = {0x00, {9, 15, slot, TASK_EVERY_DAY, 1, channel}, 6};
+        handleCommand(add);
+        busFlush();
+        if (tasksVersion() == v && tasksGet(slot) == before) addRejected++;
+    }
+    printf("0x00 adds on a channel without a motor: %d of 2 rejected\n", addRejected);
+    verify(addRejected == 2, "0x00 add on a channel without a motor was applied");
+
+    // Выгрузка: вся таблица и изменения со времени v0 на втором телефоне
+    Exchange down = exchange(downloadFrames(0, true), SYNC_DOWNLOAD | SYNC_REPLY);
+    printExchange("0x05 full download", down, downloadedRecords(down), 1);
+    Exchange downInc = exchange(downloadFrames(v0, false), SYNC_DOWNLOAD | SYNC_REPLY);
+    printExchange("0x05 changes since v0", downInc, downloadedRecords(downInc), 1);
+    Exchange same = exchange(downloadFrames(tasksVersion(), false), SYNC_DOWNLOAD | SYNC_REPLY);
+    printExchange("0x05 already in sync", same, downloadedRecords(same), 1);
+
+    // Загруженное совпадает с таблицей устройства, в том числе после перезапуска
+    int mismatches = 0;
+    std::vector<TaskEntry> expect(MAX_TASK, TASK_FREE);
+    for (const auto &r : table) expect[r.first] = r.second;
+    for (const auto &r : diff) expect[r.first] = taskUsed(r.second) ? r.second : TASK_FREE;
+    for (int i = 0; i < MAX_TASK; i++) if (tasksGet(i) != expect[i]) mismatches++;
+    uint16_t version = tasksVersion();
+    setup();
+    int rebootMismatches = 0;
+    for (int i = 0; i < MAX_TASK; i++) if (tasksGet(i) != expect[i]) rebootMismatches++;
+    Exchange afterBoot = exchange(downloadFrames(v0, false), SYNC_DOWNLOAD | SYNC_REPLY);
+    printf("applied: %d mismatches, after reboot %d, version %u -> %u, "
+           "changes since v0 after reboot: %zu records (full)\n",
+           mismatches, rebootMismatches, version, tasksVersion(), downloadedRecords(afterBoot));
+    verify(mismatches == 0 && rebootMismatches == 0, "uploaded table differs from the device table");
+
+    // Ответ 0x05 длиннее очереди передачи уходит по кадру за проход и не задерживает кормление
+    const int tasks = 200;
+    double quiet = feedingAtMs(tasks, false), busy = feedingAtMs(tasks, true);
+    printf("feeding due during a 0x05 reply of %d tasks: fed %.1f ms after the clock was set (%.1f ms without)\n",
+           tasks, busy, quiet);
+    verify(busy - quiet <= 1.0, "0x05 reply delays a scheduled feeding");
+}
+
+// Худший проход loop() при потоке правок расписания во время выдачи порции.
+// Синхронный режим — каждый проход дожидается всей записи в EEPROM, как до очереди
+static void runBusEdits(const char *name, bool sync) {
+    busFlush();
+    fakeReset();
+    setup();
+    busFlush();
+
+    // Правка раз в 25 мс: журнал заполняется, и часть правок вызывает сохранение образа
+    const int edits = 200;
+    for (int i = 0; i < edits; i++) {
+        uint8_t payload[3] = {(uint8_t)(i % 24), (uint8_t)(i % 60), (uint8_t)(i % MAX_TASK)};
+        uint8_t frame[4 + MAX_PAYLOAD_SIZE];
+        size_t n = makeFrame(0x00, payload, 3, frame);
+        board.uart.feed(frame, n, fakeNow() + 25000ULL * i);
+    }
+    motionEnqueue(SPEED, PARTITION, 1);
+
+    uint32_t passes = 0;
+    uint64_t worst = 0, sum = 0;
+    uint32_t frames0 = framerStats().frames;
+    uint32_t ckpt0 = storeStats().checkpoints;
+    uint32_t polls0 = busStats().polls;
+    uint64_t end = fakeNow() + 25000ULL * edits + 100000;
+    while (fakeNow() < end || !busIdle()) {
+        uint64_t t0 = fakeNow();
+        loop();
+        if (sync) busFlush();
+        fakeAdvance(LOOP_PASS_US);
+        uint64_t pass = fakeNow() - t0;
+        sum += pass;
+        if (pass > worst) worst = pass;
+        passes++;
+    }
+    printf("%-26s %10u %10.1f %10llu %8u %8u %8u\n", name, passes, (double)sum / passes,
+           (unsigned long long)worst, framerStats().frames - frames0,
+           storeStats().checkpoints - ckpt0, busStats().polls - polls0);
+}
+
+static void benchBus() {
+    printf("\n== i2c queue (200 edits every 25 ms during a portion)\n");
+    printf("%-26s %10s %10s %10s %8s %8s %8s\n",
+           "mode", "passes", "mean us", "worst us", "frames", "ckpts", "polls");
+    runBusEdits("synchronous (old)", true);
+    runBusEdits("queued, one step/pass", false);
+}
+
+#if PROFILE
+static const char *const profNames[] = {
+#define PROF_NAME(name, text) text,
+    PROF_REGIONS(PROF_NAME)
+#undef PROF_NAME
+};
+
+#endif
+
+static uint32_t get32le(const uint8_t *p) {
+    return p[0] | (p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+#if PROFILE
+
+// Поток правок и порция, затем выгрузка таблицы командой 0x07, как из приложения.
+// На хосте счётчик тактов — виртуальное время: видны ожидания шин, не работа ядра
+static void benchProf() {
+    printf("\n== profiler (200 edits every 25 ms, a portion, 0x09 list; dump via 0x07)\n");
+    busFlush();
+    fakeReset();
+    setup();
+    busFlush();
+
+    // Цена одного замера на хосте
+    const int n = 1000000;
+    auto h0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < n; i++) { PROF_SCOPE(PROF_LOG_DRAIN); }
+    auto h1 = std::chrono::steady_clock::now();
+    double scopeNs = std::chrono::duration<double, std::nano>(h1 - h0).count() / n;
+    profReset();
+
+    for (int i = 0; i < 200; i++) {
+        uint8_t payload[3] = {(uint8_t)(i % 24), (uint8_t)(i % 60), (uint8_t)(i % MAX_TASK)};
+        uint8_t frame[4 + MAX_PAYLOAD_SIZE];
+        size_t len = makeFrame(0x00, payload, 3, frame);
+        board.uart.feed(frame, len, fakeNow() + 25000ULL * i);
+    }
+    uint8_t list[4];
+    board.uart.feed(list, makeFrame(TASK_LIST_COMMAND, nullptr, 0, list), fakeNow() + 5000000);
+    motionEnqueue(SPEED, PARTITION, 1);
+    uint64_t end = fakeNow() + 6000000;
+    while (fakeNow() < end || !busIdle()) { loop(); fakeAdvance(LOOP_PASS_US); }
+
+    uint8_t request[5], flags = PROF_RESET;
+    size_t txFrom = board.uart.tx.size();
+    board.uart.feed(request, makeFrame(PROF_COMMAND, &flags, 1, request));
+    std::vector<Reply> replies;
+    for (int pass = 0; pass < 100000 && replies.size() < PROF_REGION_COUNT; pass++) {
+        loop();
+        fakeAdvance(LOOP_PASS_US);
+        replies = parseReplies(txFrom);
+    }
+
+    printf("%-18s %8s %10s %10s %10s  %s\n", "region", "count", "min us", "mean us", "max us", "log2 histogram (cycles)");
+    size_t blob = 0;
+    for (const Reply &r : replies) {
+        if (r.cmd != PROF_REPLY || r.payload.size() < PROF_FRAME_HEAD) continue;
+        const uint8_t *p = r.payload.data();
+        blob += r.payload.size() + 4;
+        uint32_t count = get32le(p + 2);
+        printf("%-18s %8u %10.1f %10.1f %10.1f ", p[0] < PROF_REGION_COUNT ? profNames[p[0]] : "?", count,
+               get32le(p + 6) * 1e6 / CPU_HZ, get32le(p + 14) * 1e6 / CPU_HZ, get32le(p + 10) * 1e6 / CPU_HZ);
+        for (uint8_t b = 0; b < p[19]; b++) {
+            uint16_t c = p[PROF_FRAME_HEAD + 2 * b] | (p[PROF_FRAME_HEAD + 2 * b + 1] << 8);
+            if (c) printf(" 2^%u:%u", p[18] + b, c);
+        }
+        printf("\n");
+    }
+    printf("dump: %zu frames, %zu bytes; table %zu bytes of RAM; %.1f ns per scope on host; "
+           "after reset loop count %u\n", replies.size(), blob, sizeof(ProfEntry) * PROF_REGION_COUNT,
+           scopeNs, profEntry(PROF_LOOP).count);
+}
+#endif
+
+// Сутки работы со сном между событиями: доля времени без сна и причины пробуждений.
+// Проход loop() условно стоит LOOP_PASS_US; без сна ядро не спит никогда
+static void runIdle(const char *name, int8_t intPin, bool traffic) {
+    busFlush();
+    fakeReset();
+    setup();
+    busFlush();
+    board.rtc.intPin = intPin;
+    schedBegin(intPin, feedTask);
+    addTask(0, Time{8, 0});
+    addTask(1, Time{13, 0});
+    addTask(2, Time{20, 0});
+    busFlush();
+
+    const uint64_t day = 86400ULL * 1000000ULL;
+    if (traffic) {
+        // Утром приложение правит расписание: 50 правок раз в 200 мс и выгрузка
+        for (int i = 0; i < 50; i++) {
+            uint8_t payload[3] = {(uint8_t)(9 + i % 10), (uint8_t)(i % 60), (uint8_t)(3 + i)};
+            uint8_t frame[4 + MAX_PAYLOAD_SIZE];
+            board.uart.feed(frame, makeFrame(0x00, payload, 3, frame), fakeNow() + 3600000000ULL + 200000ULL * i);
+        }
+        uint8_t since[3] = {0, 0, SYNC_FULL}, frame[8];
+        board.uart.feed(frame, makeFrame(SYNC_DOWNLOAD, since, 3, frame), fakeNow() + 3700000000ULL);
+    }
+
+    idleEnable(true);
+    idleBegin();
+    uint32_t fired0 = schedStats().fired, fired = fired0, frames0 = framerStats().frames, passes = 0;
+    double lateWorst = 0;
+    uint64_t end = fakeNow() + day;
+    while (fakeNow() < end) {
+        loop();
+        fakeAdvance(LOOP_PASS_US);
+        passes++;
+        if (schedStats().fired != fired) {
+            fired = schedStats().fired;
+            double late = (double)(board.rtc.epoch() % 60);
+            if (late > lateWorst) lateWorst = late;
+        }
+    }
+    idleEnable(false);
+
+    const IdleStats &s = idleStats();
+    double total = (double)(s.awakeUs + s.asleepUs);
+    printf("%-24s %8u %9.1f %8.4f %8u %8u %6u %6u %6u %6u %6u %6u %5.0f\n", name, passes,
+           s.awakeUs / 1000.0, 100.0 * s.awakeUs / total, s.sleeps, s.busyPasses, s.wakes[IDLE_WAKE_DEADLINE],
+           s.wakes[IDLE_WAKE_UART], s.wakes[IDLE_WAKE_RTC], s.wakes[IDLE_WAKE_MOTION],
+           schedStats().fired - fired0, framerStats().frames - frames0, lateWorst);
+    while (motionBusy()) { loop(); fakeAdvance(LOOP_PASS_US); }
+}
+
+static void benchIdle() {
+    printf("\n== idle (1 day, 3 feedings; loop pass costs %d us)\n", LOOP_PASS_US);
+    printf("%-24s %8s %9s %8s %8s %8s %6s %6s %6s %6s %6s %6s %5s\n", "mode", "passes", "awake ms", "awake %",
+           "sleeps", "busy", "w:due", "w:uart", "w:rtc", "w:motor", "feeds", "frames", "late");
+    printf("%-24s %8.2g %9.0f %8.4f %8s %8s %6s %6s %6s %6s %6s %6s %5s\n", "no sleep (old)",
+           86400e6 / LOOP_PASS_US, 86400e3, 100.0, "-", "-", "-", "-", "-", "-", "3", "-", "-");
+    runIdle("millis deadline", -1, false);
+    runIdle("DS3231 alarm on INT", 2, false);
+    runIdle("INT + BLE edits, sync", 2, true);
+}
+
+// Согласование скорости с модулем в разных состояниях
+static void runBle(const char *name, uint32_t moduleBaud, bool baudCommand, bool connected) {
+    board.uart.moduleBaud = moduleBaud;
+    board.uart.baudCommand = baudCommand;
+    board.uart.connected = connected;
+    uint32_t commands0 = board.uart.atCommands;
+    uint64_t t0 = fakeNow();
+    BleResult r = bleBegin();
+    static const char *const results[] = {"fast", "switched", "rejected", "silent"};
+    printf("%-30s %8.1f %8u %9s %8u %8u\n", name, (fakeNow() - t0) / 1000.0, bleBaud(), results[r],
+           board.uart.moduleBaud, board.uart.atCommands - commands0);
+    board.uart.connected = false;
+    board.uart.baudCommand = true;
+}
+
+// Кадр ответа: сколько ждёт вызывающий и когда последний байт уходит в линию
+static void runUartFrame(uint32_t baud, bool queued) {
+    uint8_t frame[4 + MAX_PAYLOAD_SIZE];
+    for (size_t i = 0; i < sizeof(frame); i++) frame[i] = (uint8_t)i;
+    uartBegin(baud);
+    uint64_t t0 = fakeNow();
+    if (queued) uartWrite(frame, sizeof(frame));
+    else halUartWrite(frame, sizeof(frame));
+    double callUs = (double)(fakeNow() - t0);
+    uint32_t refills0 = uartStats().refills;
+    uartFlush();
+    printf("%-30s %8u %10.0f %10.1f %8u\n", queued ? "uartWrite (ring + timer)" : "halUartWrite (blocking)",
+           baud, callUs, (board.uart.txLineFreeAt() - t0) / 1000.0, uartStats().refills - refills0);
+}
+
+// Поток байтов через очередь: доля занятости линии
+static void runUartStream(uint32_t baud, size_t total) {
+    uint8_t chunk[64];
+    for (size_t i = 0; i < sizeof(chunk); i++) chunk[i] = (uint8_t)i;
+    uartBegin(baud);
+    size_t tx0 = board.uart.tx.size();
+    uint32_t refills0 = uartStats().refills, waits0 = uartStats().waits;
+    uint64_t t0 = fakeNow();
+    for (size_t sent = 0; sent < total; sent += sizeof(chunk)) uartWriteAll(chunk, sizeof(chunk));
+    uartFlush();
+    size_t bytes = board.uart.tx.size() - tx0;
+    double seconds = (board.uart.txLineFreeAt() - t0) / 1e6;
+    printf("%-30s %8u %10zu %9.1f%% %8u %8u\n", "uartWriteAll stream", baud, bytes,
+           100.0 * bytes * board.uart.byteTimeUs() / 1e6 / seconds, uartStats().refills - refills0, uartStats().waits - waits0);
+}
+
+static void benchUart() {
+    printf("\n== ble uart (%d B frame; TX ring %d B, refill every %d bytes)\n",
+           4 + MAX_PAYLOAD_SIZE, UART_TX_SIZE, UART_TX_REFILL);
+    printf("%-30s %8s %10s %10s %8s\n", "write", "baud", "caller us", "line ms", "refills");
+    busFlush();
+    fakeReset();
+    for (uint32_t baud : {9600UL, 115200UL}) {
+        runUartFrame(baud, false);
+        runUartFrame(baud, true);
+    }
+    printf("%-30s %8s %10s %10s %8s %8s\n", "stream", "baud", "bytes", "line busy", "refills", "waits");
+    for (uint32_t baud : {9600UL, 115200UL}) runUartStream(baud, 16384);
+
+    printf("%-30s %8s %8s %9s %8s %8s\n", "module", "ms", "baud", "result", "module", "AT cmds");
+    runBle("factory 9600, accepts BAUD", 9600, true, false);
+    runBle("already at 115200", 115200, true, false);
+    runBle("firmware without AT+BAUD", 9600, false, false);
+    runBle("phone connected", 9600, true, true);
+    runBle("not answering", 4800, true, false);
+
+    // Ответ на 0x09 после согласования: кадры уходят из loop(), обработчик не ждёт
+    busFlush();
+    fakeReset();
+    setup();
+    while (!busIdle() || storeBusy()) { loop(); fakeAdvance(LOOP_PASS_US); }
+    for (int i = 0; i < 64; i++) addTask(i, Time{(uint8_t)(i % 24), (uint8_t)(i % 60)});
+    busFlush();
+    uartFlush();
+    Packet list = {TASK_LIST_COMMAND, {0}, 0};
+    size_t txFrom = board.uart.tx.size();
+    uint64_t t0 = fakeNow();
+    handleCommand(list);
+    double callMs = (fakeNow() - t0) / 1000.0;
+    while (taskListStreaming()) { loop(); fakeAdvance(LOOP_PASS_US); }
+    uartFlush();
+    printf("0x09 list of %u tasks at %u baud: handler %.1f ms, reply on the line %.1f ms\n",
+           tasksUsed(), bleBaud(), callMs, (board.uart.txLineFreeAt() - t0) / 1000.0);
+
+    // Кадры 0x89 по порядку, последний с TASK_LIST_LAST, записи совпадают с таблицей
+    std::vector<Reply> replies = parseReplies(txFrom);
+    size_t records = 0, mismatches = 0;
+    bool order = !replies.empty();
+    for (size_t f = 0; f < replies.size(); f++) {
+        const Reply &r = replies[f];
+        bool last = f + 1 == replies.size();
+        order = order && r.cmd == TASK_LIST_REPLY &&
+                r.payload[0] == ((last ? TASK_LIST_LAST : 0) | f);
+        for (size_t off = TASK_LIST_HEADER; off + TASK_LIST_RECORD <= r.payload.size(); off += TASK_LIST_RECORD) {
+            const uint8_t *rec = &r.payload[off];
+            TaskEntry e = tasksGet(rec[0]);
+            if (!taskUsed(e) || rec[1] != taskHours(e) || rec[2] != taskMinutes(e) ||
+                rec[3] != taskDays(e) || rec[4] != taskPortions(e)) mismatches++;
+            records++;
+        }
+    }
+    printf("  %zu frames 0x89, %zu records, %zu mismatched\n", replies.size(), records, mismatches);
+    verify(order && records == tasksUsed() && mismatches == 0, "0x09 list frames do not match the task table");
+}
+
+// Событие истории в разборе приложения
+struct HistoryEvent {
+    uint32_t epoch;
+    uint8_t cause, task, portions;
+    bool operator==(const HistoryEvent &o) const {
+        return epoch == o.epoch && cause == o.cause && task == o.task && portions == o.portions;
+    }
+};
+
+// Кадры 0x88 так, как их разбирает приложение: страницы и события по формату history.h
+struct HistoryDump {
+    std::vector<HistoryEvent> events;
+    size_t frames = 0, pages = 0, bytes = 0;
+    bool gap = false;
+};
+
+static void decodeHistoryFrame(const Reply &r, HistoryDump &d) {
+    d.frames++;
+    if (r.payload[2] & HISTORY_GAP) d.gap = true;
+    size_t at = HISTORY_FRAME_HEAD;
+    while (at < r.payload.size()) {
+        uint8_t len = r.payload[at];
+        const uint8_t *p = &r.payload[at + 1];
+        at += 1 + len;
+        if (len < HISTORY_PAGE_HEAD) continue;
+        d.pages++;
+        uint32_t t = get32le(p + 2);
+        for (size_t i = HISTORY_PAGE_HEAD; i < len;) {
+            HistoryEvent e{0, (uint8_t)((p[i] >> 4) & 0x03), p[i + 1], (uint8_t)(p[i] & 0x0F)};
+            uint32_t delta = 0;
+            int shift = 0;
+            for (i += 2; p[i] & 0x80; i++, shift += 7) delta |= (uint32_t)(p[i] & 0x7F) << shift;
+            delta |= (uint32_t)p[i++] << shift;
+            t += delta;
+            e.epoch = t;
+            d.events.push_back(e);
+        }
+    }
+}
+
+// Запрос 0x08 и работа loop(), пока не придёт кадр с HISTORY_LAST
+static HistoryDump dumpHistory(const uint8_t *payload, uint8_t len, double *ms, uint64_t *worstPass) {
+    HistoryDump d;
+    size_t txFrom = board.uart.tx.size();
+    std::vector<uint8_t> f = frameOf(HISTORY_COMMAND, payload, len);
+    uint64_t start = fakeNow();
+    board.uart.feed(f.data(), f.size());
+    *worstPass = 0;
+    for (bool last = false; !last;) {
+        uint64_t p0 = fakeNow();
+        loop();
+        fakeAdvance(LOOP_PASS_US);
+        if (fakeNow() - p0 > *worstPass) *worstPass = fakeNow() - p0;
+        std::vector<Reply> replies = parseReplies(txFrom);
+        for (const Reply &r : replies) {
+            if (r.cmd == HISTORY_REPLY && (r.payload[2] & HISTORY_LAST)) last = true;
+        }
+        if (!last) continue;
+        for (const Reply &r : replies) if (r.cmd == HISTORY_REPLY) decodeHistoryFrame(r, d);
+    }
+    while (uartBusy()) { loop(); fakeAdvance(LOOP_PASS_US); }
+    *ms = (board.uart.txLineFreeAt() - start) / 1000.0;
+    d.bytes = board.uart.tx.size() - txFrom;
+    return d;
+}
+
+// Совпадает ли выгрузка с концом записанной последовательности
+static bool historyTailMatches(const std::vector<HistoryEvent> &written, const std::vector<HistoryEvent> &got) {
+    return got.size() <= written.size() && std::equal(got.begin(), got.end(), written.end() - got.size());
+}
+
+static void benchHistory() {
+    busFlush();
+    fakeReset();
+    setup();
+    while (!busIdle() || storeBusy()) { loop(); fakeAdvance(LOOP_PASS_US); }
+    printf("\n== feeding history (%d B of EEPROM, %d pages, %u baud)\n", HISTORY_SIZE, HISTORY_PAGES, bleBaud());
+
+    // Три кормления в день на несколько секунд позже минуты (время выдачи),
+    // раз в несколько дней — порция по 0x04 в случайное время
+    std::vector<HistoryEvent> written;
+    uint32_t seed = 17;
+    auto rnd = [&] { seed = seed * 1103515245 + 12345; return seed >> 8; };
+    uint32_t day0 = epochFromCivil(2025, 3, 1, 0, 0, 0);
+    uint32_t pages0 = historyStats().pages;
+    for (uint32_t day = 0; day < 120; day++) {
+        static const uint16_t minutes[] = {8 * 60, 13 * 60, 20 * 60};
+        for (uint8_t k = 0; k < 3; k++) {
+            HistoryEvent e{day0 + day * 86400 + minutes[k] * 60 + 1 + rnd() % 3, HISTORY_SCHEDULED, k,
+                           (uint8_t)(rnd() % 3 + 1)};
+            if (rnd() % 9 == 0) {
+                uint32_t t = e.epoch - 3600 * (1 + rnd() % 4);
+                HistoryEvent m{t, HISTORY_MANUAL, 0, 1};
+                if (written.empty() || t > written.back().epoch) {
+                    historyAppend(m.epoch, m.cause, m.task, m.portions);
+                    written.push_back(m);
+                }
+            }
+            historyAppend(e.epoch, e.cause, e.task, e.portions);
+            written.push_back(e);
+            busFlush();
+        }
+    }
+    uint32_t pages = historyStats().pages - pages0;
+    printf("%zu events over 120 days, %u pages: %.2f B/event with page headers, %.0f events/KB\n",
+           written.size(), pages, (double)pages * EEPROM_PAGE / written.size(), written.size() * 1024.0 / pages / EEPROM_PAGE);
+
+    double ms;
+    uint64_t worstPass;
+    HistoryDump full = dumpHistory(nullptr, 0, &ms, &worstPass);
+    double days = full.events.empty() ? 0 : (full.events.back().epoch - full.events.front().epoch) / 86400.0;
+    printf("full dump: %zu events (%.0f days), %zu pages in %zu frames, %zu B, %.1f ms on the line, "
+           "worst loop pass %llu us, %s\n",
+           full.events.size(), days, full.pages, full.frames, full.bytes, ms, (unsigned long long)worstPass,
+           historyTailMatches(written, full.events) ? "matches" : "MISMATCH");
+    verify(historyTailMatches(written, full.events), "history dump differs from the written events");
+
+    // Продолжение с середины и с уже перезаписанной страницы
+    uint16_t mid = historyStats().seq - HISTORY_PAGES / 2;
+    uint8_t from[2] = {(uint8_t)(mid & 0xFF), (uint8_t)(mid >> 8)};
+    HistoryDump resumed = dumpHistory(from, sizeof(from), &ms, &worstPass);
+    printf("resume from page %u: %zu events in %zu frames, %.1f ms, %s\n", mid, resumed.events.size(),
+           resumed.frames, ms, historyTailMatches(written, resumed.events) ? "matches" : "MISMATCH");
+    verify(historyTailMatches(written, resumed.events), "resumed history dump differs from the written events");
+    uint16_t lost = historyStats().seq - HISTORY_PAGES - 5;
+    uint8_t stale[2] = {(uint8_t)(lost & 0xFF), (uint8_t)(lost >> 8)};
+    HistoryDump wrapped = dumpHistory(stale, sizeof(stale), &ms, &worstPass);
+    printf("resume from overwritten page %u: gap flag %s, %zu events\n", lost, wrapped.gap ? "set" : "MISSING",
+           wrapped.events.size());
+    verify(wrapped.gap, "resume from an overwritten page has no gap flag");
+
+    // Перезапуск: текущая страница находится заново, события дописываются в неё
+    HistoryStats before = historyStats();
+    uint32_t tx0 = board.bus.stats.transactions;
+    uint64_t t0 = fakeNow();
+    historyBegin();
+    printf("historyBegin: %.2f ms, %u i2c tx, page %u, %u B used, %u pages kept\n", (fakeNow() - t0) / 1000.0,
+           board.bus.stats.transactions - tx0, historyStats().seq, historyStats().used, historyStats().valid);
+    verify(historyStats().seq == before.seq && historyStats().used == before.used &&
+           historyStats().valid == before.valid, "historyBegin does not find the current page");
+
+    // Испорченный заголовок страницы 0: остальные страницы сохраняются,
+    // испорченная выдаётся пустой
+    uint16_t crcAt = HISTORY_ADDR + HISTORY_PAGE_HEAD - 1;
+    board.eeprom.mem[crcAt] ^= 0x5A;
+    historyBegin();
+    HistoryDump damaged = dumpHistory(nullptr, 0, &ms, &worstPass);
+    printf("page 0 header corrupt: page %u, %u pages kept, %zu of %zu pages and %zu of %zu events dumped\n",
+           historyStats().seq, historyStats().valid, damaged.pages, full.pages, damaged.events.size(),
+           full.events.size());
+    verify(historyStats().seq == before.seq && historyStats().used == before.used &&
+           historyStats().valid == before.valid, "corrupt page 0 loses the current page");
+    verify(damaged.pages + 1 == full.pages, "corrupt page 0 discards other history pages");
+    verify(!damaged.events.empty() && damaged.events.back() == written.back(), "corrupt page 0 loses the last events");
+    board.eeprom.mem[crcAt] ^= 0x5A;
+    historyBegin();
+
+    // Кормления через скетч: по расписанию, по 0x04 и отказ при заполненной очереди
+    Packet manual = {0x04, {0}, 1};
+    handleCommand(manual);
+    feedTask(0);
+    for (int i = 0; i < MOTION_QUEUE; i++) handleCommand(manual);
+    while (motionBusy() || motionPending()) { loop(); fakeAdvance(LOOP_PASS_US); }
+    busFlush();
+    HistoryDump tail = dumpHistory(nullptr, 0, &ms, &worstPass);
+    unsigned counts[3] = {0, 0, 0};
+    for (size_t i = tail.events.size() - (2 + MOTION_QUEUE); i < tail.events.size(); i++) counts[tail.events[i].cause]++;
+    printf("sketch feedings: last %d events scheduled %u, manual %u, dropped %u\n", 2 + MOTION_QUEUE, counts[0],
+           counts[1], counts[2]);
+}
+
+// Стоимость прерывания звука на Cortex-M3, оценка: вход, выход и переключение вывода
+#define SOUND_ISR_CYCLES 60
+
+// Фронты SOUND по таблице мелодии: нота — целое число периодов от конца предыдущей,
+// пауза — SOUND_TICK_MS на единицу без фронтов
+static uint64_t soundSchedule(SoundCue cue, uint64_t t, std::vector<uint64_t> &edges, uint32_t *nominalMs) {
+    *nominalMs = 0;
+    for (const SoundNote *n = soundMelody(cue); n->ticks; n++) {
+        *nominalMs += n->ticks * SOUND_TICK_MS;
+        if (n->note == SOUND_REST) {
+            t += (uint64_t)n->ticks * SOUND_TICK_MS * 1000;
+            continue;
+        }
+        uint16_t half = soundHalfPeriod(n->note);
+        uint32_t count = (uint32_t)n->ticks * SOUND_TICK_MS * 500 / half * 2;
+        for (uint32_t k = 0; k < count; k++) edges.push_back(t += half);
+    }
+    return t;
+}
+
+// Худшее отклонение полупериода нот мелодии от равномерной темперации, центы
+static double soundPitchCents(SoundCue cue) {
+    double worst = 0;
+    for (const SoundNote *n = soundMelody(cue); n->ticks; n++) {
+        if (n->note == SOUND_REST) continue;
+        double ideal = 500000.0 / (440.0 * pow(2.0, (n->note - 69) / 12.0));
+        double cents = fabs(1200.0 * log2(ideal / soundHalfPeriod(n->note)));
+        if (cents > worst) worst = cents;
+    }
+    return worst;
+}
+
+// Сигналы подряд через очередь: фронты против таблиц, проходы loop() во время звука
+static void runSound(const char *name, const std::vector<SoundCue> &cues) {
+    while (soundBusy()) fakeAdvance(1000);
+    FakePin &pin = board.pins[SOUND];
+    pin.trace = true;
+    pin.edgeTimes.clear();
+    uint32_t irq0 = soundStats().interrupts, dropped0 = soundStats().dropped;
+
+    uint64_t t0 = fakeNow(), worstPass = 0, worstPlay = 0;
+    size_t queued = 0;
+    std::vector<SoundCue> accepted;
+    for (SoundCue c : cues) {
+        uint64_t p0 = fakeNow();
+        if (soundPlay(c)) accepted.push_back(c);
+        if (fakeNow() - p0 > worstPlay) worstPlay = fakeNow() - p0;
+        queued++;
+    }
+    while (soundBusy()) {
+        uint64_t p0 = fakeNow();
+        loop();
+        if (fakeNow() - p0 > worstPass) worstPass = fakeNow() - p0;
+        fakeAdvance(LOOP_PASS_US);
+    }
+    pin.trace = false;
+
+    std::vector<uint64_t> expect;
+    uint64_t t = t0;
+    uint32_t nominal = 0;
+    double cents = 0;
+    for (SoundCue c : accepted) {
+        uint32_t ms;
+        t = soundSchedule(c, t, expect, &ms);
+        nominal += ms;
+        if (soundPitchCents(c) > cents) cents = soundPitchCents(c);
+    }
+    double worst = 0;
+    for (size_t i = 0; i < expect.size() && i < pin.edgeTimes.size(); i++) {
+        double dev = fabs((double)pin.edgeTimes[i] - (double)expect[i]);
+        if (dev > worst) worst = dev;
+    }
+    double ms = pin.edgeTimes.empty() ? 0 : (pin.edgeTimes.back() - t0) / 1000.0;
+    uint32_t irq = soundStats().interrupts - irq0;
+    printf("%-22s %3zu/%zu %7.1f %7u %6zu/%-6zu %6.0f %7.2f %6.2f%% %8llu %8llu %s\n", name, accepted.size(), queued,
+           ms, nominal, pin.edgeTimes.size(), expect.size(), worst, cents,
+           100.0 * irq * SOUND_ISR_CYCLES / (CPU_HZ / 1e6) / (ms * 1000.0), (unsigned long long)worstPlay,
+           (unsigned long long)worstPass, pin.level ? "off" : "ON");
+    verify(soundStats().dropped - dropped0 == queued - accepted.size(), "sound dropped count does not match");
+    verify(pin.edgeTimes.size() == expect.size(), "sound cue made a different number of edges");
+    verify(worst == 0, "sound edges stray from the note table");
+    verify(ms <= nominal, "sound cue lasts longer than its table");
+    verify(pin.level, "buzzer is left on after the cue");
+}
+
+// Кормление со звуком: фронты STEP те же, что без звука, loop() не ждёт
+static void runSoundFeeding() {
+    const MotionChannel &m = motionChannel(0);
+    FakePin &step = board.pins[m.step];
+    std::vector<uint64_t> quiet, loud;
+    for (int withSound = 0; withSound < 2; withSound++) {
+        while (soundBusy() || motionBusy()) { loop(); fakeAdvance(LOOP_PASS_US); }
+        step.trace = true;
+        step.edgeTimes.clear();
+        uint64_t t0 = fakeNow();
+        if (withSound) feedTask(0);
+        else motionEnqueue(m.speed, m.partition * taskPortions(tasksGet(0)), 1, 0);
+        while (motionBusy() || motionPending()) { loop(); fakeAdvance(LOOP_PASS_US); }
+        step.trace = false;
+        for (uint64_t &e : step.edgeTimes) e -= t0;
+        (withSound ? loud : quiet) = step.edgeTimes;
+    }
+    uint32_t nominal;
+    std::vector<uint64_t> melody;
+    soundSchedule(SOUND_FEEDING, 0, melody, &nominal);
+    printf("feeding: %zu STEP edges %s with the cue playing; a blocking beep of the cue would hold loop() %u ms\n",
+           loud.size(), loud == quiet ? "identical" : "DIFFERENT", nominal);
+    verify(!loud.empty() && loud == quiet, "the cue changes the STEP pulse train");
+}
+
+static void benchSound() {
+    while (motionBusy()) { loop(); fakeAdvance(LOOP_PASS_US); }
+    printf("\n== sound cues (timer-driven, queue %d, note unit %d ms, isr cost %d cycles)\n", SOUND_QUEUE,
+           SOUND_TICK_MS, SOUND_ISR_CYCLES);
+    printf("%-22s %7s %7s %7s %13s %6s %7s %7s %8s %8s %s\n", "cues", "queued", "ms", "table", "edges",
+           "dev us", "cents", "cpu", "play us", "pass us", "end");
+    runSound("feeding", {SOUND_FEEDING});
+    runSound("connected", {SOUND_CONNECTED});
+    runSound("error", {SOUND_ERROR});
+    runSound("error+feeding+conn", {SOUND_ERROR, SOUND_FEEDING, SOUND_CONNECTED});
+    runSound("6 cues at once", std::vector<SoundCue>(6, SOUND_CONNECTED));
+    runSoundFeeding();
+}
+
+int main() {
+    idleEnable(false);          // Замеры проходов loop() — без сна
+    fakeReset();
+    setup();
+    benchSketch();
+    benchMotion();
+    benchFramer();
+    benchScheduler();
+    benchClock();
+    benchCalendar();
+    benchStore();
+    benchBoot();
+    benchTasks();
+    benchSync();
+    benchBus();
+#if PROFILE
+    benchProf();
+#endif
+    benchIdle();
+    benchUart();
+    benchHistory();
+    benchSound();
+
+    printf("\ndebug serial bytes: %u, eeprom page writes: %u\n",
+           Serial.bytesWritten, board.eeprom.pageWrites);
+    return checkResult();
+}
@@ -0,0 +1,82 @@
+// Задержка handleCommand на уровне журнала LOG_LEVEL этой сборки.
+// Собирается для каждого уровня (bench_log0 … bench_log4, цель bench_log).
+// Для сравнения выводится, сколько занял бы тот же текст, напечатанный
+// блокирующим Serial.print на 115200 бод, как до двоичного журнала.
+
+#include <stdio.h>
+#include <chrono>
+#include <string>
+
+#include "Arduino.h"
+#include "bus.h"
+#include "fake.h"
+#include "log.h"
+#include "logdecode.h"
+#include "main.h"
+#include "uart.h"
+
+static const char *const levelNames[] = {"none", "error", "warn", "info", "debug"};
+
+static LogDecoder decoder;
+
+// Передать журнал в Serial вне замера и перевести в текст; возвращает длину текста
+static size_t drain() {
+    while (logPending() > 0) logDrainChunk();
+    std::string text;
+    decoder.feed(Serial.captured.data(), Serial.captured.size(), text);
+    Serial.captured.clear();
+    return text.size();
+}
+
+static void run(const char *name, const Packet &pkt, int iterations) {
+    double hostNs = 0, virtUs = 0, worstUs = 0, logBytes = 0, textBytes = 0;
+    for (int i = 0; i < iterations; i++) {
+        busFlush();
+        uartFlush();
+        drain();
+        uint16_t pending0 = logPending();
+        uint64_t v0 = fakeNow();
+        auto h0 = std::chrono::steady_clock::now();
+        handleCommand(pkt);
+        taskListPoll();                 // Кадр ответа 0x09 уходит в том же проходе loop()
+        auto h1 = std::chrono::steady_clock::now();
+        double v = (double)(fakeNow() - v0);
+        hostNs += std::chrono::duration<double, std::nano>(h1 - h0).count();
+        virtUs += v;
+        if (v > worstUs) worstUs = v;
+        logBytes += logPending() - pending0;
+        textBytes += drain();
+    }
+    printf("%-26s %10.0f %10.1f %10.1f %9.1f %9.1f %12.1f\n", name, hostNs / iterations,
+           virtUs / iterations, worstUs, logBytes / iterations, textBytes / iterations,
+           textBytes / iterations * 10 * 1e6 / 115200);
+}
+
+int main() {
+    fakeReset();
+    Serial.capture = true;
+    setup();
+    for (uint8_t i = 0; i < 16; i++) addTask(i, Time{(uint8_t)(6 + i), 15}, TASK_EVERY_DAY, 2);
+    busFlush();
+    drain();
+
+    printf("\n== handleCommand at log level %d (%s)\n", LOG_LEVEL, levelNames[LOG_LEVEL]);
+    printf("%-26s %10s %10s %10s %9s %9s %12s\n",
+           "command", "host ns", "virt us", "worst us", "log B", "text B", "print us");
+
+    Packet add = {0x00, {8, 30, 20, TASK_EVERY_DAY, 2}, 5};
+    run("0x00 add", add, 200);
+    Packet remove = {0x01, {20}, 1};
+    run("0x01 remove", remove, 200);
+    Packet list = {TASK_LIST_COMMAND, {0}, 0};
+    run("0x09 list (16 tasks)", list, 50);
+    Packet set = {0x03, {0, 30, 12, 15, 6, 25}, 6};
+    run("0x03 set time", set, 200);
+    Packet unknown = {0x7F, {0}, 0};
+    run("0x7F unknown", unknown, 200);
+
+    const LogStats &s = logStats();
+    printf("records %u, lost %u, buffer peak %u of %d B, decoder unknown bytes %u\n",
+           s.records, s.lost, s.maxUsed, LOG_BUFFER, decoder.unknown);
+    return 0;
+}
@@ -0,0 +1,154 @@
+// Несколько двигателей на одном таймере: точность фронтов каждого канала
+// и нагрузка прерывания в зависимости от числа одновременно работающих каналов.
+// Скетч собирается с MOTION_CHANNELS=4 (цель bench_motion), каналы берут
+// скорость и длину порции из MOTION_CHANNEL_TABLE.
+// Проверки (verify) печатают FAIL и дают ненулевой код выхода (ctest).
+
+#include <math.h>
+#include <stdio.h>
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+#include "check.h"
+#include "fake.h"
+#include "hal.h"
+#include "motion.h"
+
+// Стоимость прерывания на Cortex-M3, оценка: вход и выход, проверка канала, фронт
+#define ISR_BASE_CYCLES 40
+#define ISR_CHANNEL_CYCLES 12
+#define ISR_EDGE_CYCLES 60
+
+struct ChannelResult {
+    size_t edges = 0;
+    double start = 0;               // Первый фронт позже полупериода шага 0 от постановки в очередь, мкс
+    double rms = 0, worst = 0;      // Отклонение интервала между фронтами от таблицы, мкс
+    double rateErr = 0;             // Длительность перемещения против суммы полупериодов, %
+};
+
+// Интервал перед фронтом i — половина шага i / 2. Канал, поставленный в очередь
+// при работающем таймере, начинает на ближайшем прерывании — это задержка
+// старта, интервалы считаются от первого фронта
+static ChannelResult checkEdges(const std::vector<uint64_t> &edges, uint64_t queued, uint16_t speed, uint16_t iter) {
+    ChannelResult r;
+    r.edges = edges.size();
+    if (edges.size() < 2) return r;
+    r.start = (double)(edges[0] - queued) - motionHalfPeriod(speed, iter, 0);
+    double sum2 = 0, intended = 0;
+    for (size_t i = 1; i < edges.size(); i++) {
+        double half = motionHalfPeriod(speed, iter, (uint16_t)(i / 2));
+        double dev = (double)(edges[i] - edges[i - 1]) - half;
+        sum2 += dev * dev;
+        if (fabs(dev) > r.worst) r.worst = fabs(dev);
+        intended += half;
+    }
+    r.rms = sqrt(sum2 / (edges.size() - 1));
+    r.rateErr = 100.0 * ((double)(edges.back() - edges[0]) - intended) / intended;
+    return r;
+}
+
+// Все каналы 0..count-1 запускаются одновременно с порцией по своей строке таблицы
+static void runChannels(uint8_t count) {
+    for (uint8_t c = 0; c < MOTION_CHANNELS; c++) {
+        FakePin &p = board.pins[motionChannel(c).step];
+        p.trace = c < count;
+        p.edgeTimes.clear();
+    }
+    MotionStats s0 = motionStats();
+    uint32_t fires0 = board.timers[HAL_TIMER_MOTION].fires;
+    uint64_t t0 = fakeNow();
+    auto h0 = std::chrono::steady_clock::now();
+    for (uint8_t c = 0; c < count; c++) {
+        motionEnqueue(motionChannel(c).speed, motionChannel(c).partition, 1, c);
+    }
+    while (motionBusy()) { motionPoll(); fakeAdvance(LOOP_PASS_US); }
+    double hostNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - h0).count();
+    double elapsed = (double)(fakeNow() - t0);
+
+    uint32_t interrupts = motionStats().interrupts - s0.interrupts;
+    uint32_t edges = motionStats().edges - s0.edges;
+    uint32_t merged = motionStats().merged - s0.merged;
+
+    // Худшее прерывание: сколько фронтов выдано в один момент
+    std::vector<uint64_t> all;
+    double start = 0, rms = 0, worst = 0, rateErr = 0;
+    for (uint8_t c = 0; c < count; c++) {
+        const MotionChannel &m = motionChannel(c);
+        FakePin &p = board.pins[m.step];
+        ChannelResult r = checkEdges(p.edgeTimes, t0, m.speed, m.partition);
+        if (r.start > start) start = r.start;
+        if (r.rms > rms) rms = r.rms;
+        if (r.worst > worst) worst = r.worst;
+        if (fabs(r.rateErr) > fabs(rateErr)) rateErr = r.rateErr;
+        if (r.edges != 2u * m.partition) printf("  channel %u: %zu edges, expected %u\n", c, r.edges, 2 * m.partition);
+        verify(r.edges == 2u * m.partition, "channel made a different number of edges");
+        all.insert(all.end(), p.edgeTimes.begin(), p.edgeTimes.end());
+        p.trace = false;
+    }
+    std::sort(all.begin(), all.end());
+    size_t burst = 0;
+    for (size_t i = 0, j = 0; i < all.size(); i = j) {
+        while (j < all.size() && all[j] == all[i]) j++;
+        if (j - i > burst) burst = j - i;
+    }
+
+    double cycles = (double)interrupts * (ISR_BASE_CYCLES + MOTION_CHANNELS * ISR_CHANNEL_CYCLES) +
+                    (double)edges * ISR_EDGE_CYCLES;
+    double worstCycles = ISR_BASE_CYCLES + MOTION_CHANNELS * ISR_CHANNEL_CYCLES + burst * ISR_EDGE_CYCLES;
+    printf("%8u %8.1f %8u %8u %7.2f %7u %8.0f %7.2f%% %6.1f %8.0f %8.2f %8.0f %8.3f%% %8.0f\n", count,
+           elapsed / 1000.0, interrupts, edges, (double)edges / interrupts, merged, interrupts * 1e6 / elapsed,
+           100.0 * cycles / (CPU_HZ / 1e6) / elapsed, worstCycles / (CPU_HZ / 1e6), start, rms, worst, rateErr,
+           hostNs / interrupts);
+    verify(board.timers[HAL_TIMER_MOTION].fires - fires0 == interrupts, "timer fires do not match isr count");
+    // Один канал идёт точно по таблице, несколько — с досрочностью меньше окна слияния
+    verify(count > 1 || worst == 0, "single channel strays from the ramp table");
+    verify(worst < MOTION_MERGE_US, "edge strays more than the merge window");
+    verify(fabs(rateErr) < 0.01, "channel average speed differs from the ramp table");
+}
+
+// Перемещение на простаивающем канале, поставленное во время работы другого:
+// первый фронт — на ближайшем прерывании после полупериода шага 0
+static void runLateStart() {
+    const MotionChannel &a = motionChannel(0), &b = motionChannel(1);
+    FakePin &p = board.pins[b.step];
+    double worstDelay = 0, sumDelay = 0;
+    const int runs = 50;
+    for (int n = 0; n < runs; n++) {
+        motionEnqueue(a.speed, a.partition, 1, 0);
+        fakeAdvance(20000 + n * 137);
+        p.trace = true;
+        p.edgeTimes.clear();
+        uint64_t t0 = fakeNow();
+        motionEnqueue(b.speed, b.partition, 1, 1);
+        while (motionBusy()) { motionPoll(); fakeAdvance(LOOP_PASS_US); }
+        p.trace = false;
+        verify(p.edgeTimes.size() == 2u * b.partition, "late channel made a different number of edges");
+        if (p.edgeTimes.empty()) continue;
+        double delay = (double)(p.edgeTimes[0] - t0) - motionHalfPeriod(b.speed, b.partition, 0);
+        sumDelay += delay;
+        if (delay > worstDelay) worstDelay = delay;
+    }
+    printf("start on an idle channel while channel 0 runs: first edge late by %.1f us mean, %.0f us worst\n",
+           sumDelay / runs, worstDelay);
+    // Ближайшее прерывание — не позже следующего фронта канала 0
+    verify(worstDelay >= 0 && worstDelay <= motionHalfPeriod(a.speed, a.partition, 0),
+           "late start waits longer than a step of the running channel");
+}
+
+int main() {
+    fakeReset();
+    motionBegin();
+
+    printf("\n== motion channels (one timer, merge window %d us; isr cost %d + %d/channel + %d/edge cycles)\n",
+           MOTION_MERGE_US, ISR_BASE_CYCLES, ISR_CHANNEL_CYCLES, ISR_EDGE_CYCLES);
+    for (uint8_t c = 0; c < MOTION_CHANNELS; c++) {
+        const MotionChannel &m = motionChannel(c);
+        printf("channel %u: STEP %u, half-period %u us, %u steps\n", c, m.step, m.speed, m.partition);
+    }
+    printf("%8s %8s %8s %8s %7s %7s %8s %8s %6s %8s %8s %8s %9s %8s\n", "channels", "ms", "isr", "edges",
+           "e/isr", "merged", "isr/s", "cpu", "isr us", "start us", "rms us", "worst us", "rate err", "host ns");
+    for (uint8_t count = 1; count <= MOTION_CHANNELS; count++) runChannels(count);
+    runLateStart();
+    return checkResult();
+}
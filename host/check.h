@@ -0,0 +1,27 @@
+#ifndef check_h
+#define check_h
+
+// Общее для проверочных программ host/: проверки (verify) печатают FAIL и
+// дают ненулевой код выхода (ctest), проход loop() стоит одинаково везде.
+
+#include <stdio.h>
+
+// Один проход loop() вместе с условной стоимостью самого прохода
+#define LOOP_PASS_US 5
+
+inline int failures = 0;
+
+// Проверка результата: сбой печатается и учитывается в коде выхода
+inline void verify(bool ok, const char *what) {
+    if (ok) return;
+    failures++;
+    printf("FAIL: %s\n", what);
+}
+
+// Код выхода программы по числу сбоев
+inline int checkResult() {
+    if (failures) printf("%d checks FAILED\n", failures);
+    return failures ? 1 : 0;
+}
+
+#endif
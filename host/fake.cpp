@@ -0,0 +1,396 @@
+#include "fake.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+FakeBoard board;
+
+static uint64_t nowUs = 0;
+
+// Календарные преобразования для модели DS3231 (пролептический григорианский календарь)
+static int64_t daysFromCivil(int64_t y, unsigned m, unsigned d) {
+    y -= m <= 2;
+    const int64_t era = (y >= 0 ? y : y - 399) / 400;
+    const unsigned yoe = (unsigned)(y - era * 400);
+    const unsigned doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + (int64_t)doe - 719468;
+}
+
+static void civilFromDays(int64_t z, int64_t &y, unsigned &m, unsigned &d) {
+    z += 719468;
+    const int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+    const unsigned doe = (unsigned)(z - era * 146097);
+    const unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    const unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    const unsigned mp = (5 * doy + 2) / 153;
+    d = doy - (153 * mp + 2) / 5 + 1;
+    m = mp < 10 ? mp + 3 : mp - 9;
+    y = (int64_t)yoe + era * 400 + (m <= 2);
+}
+
+static const int64_t EPOCH_2000 = 10957;  // Дней от 1970-01-01 до 2000-01-01
+
+static uint8_t toBcd(unsigned v) { return (uint8_t)(((v / 10) << 4) | (v % 10)); }
+static unsigned fromBcd(uint8_t v) { return (v >> 4) * 10 + (v & 0xF); }
+
+uint64_t fakeNow() {
+    return nowUs;
+}
+
+// Детерминированный генератор для задержки входа в прерывание
+static uint32_t jitterSeed = 1;
+
+static uint32_t jitter(uint32_t range) {
+    if (range == 0) return 0;
+    jitterSeed = jitterSeed * 1103515245 + 12345;
+    return (jitterSeed >> 16) % (range + 1);
+}
+
+void fakeTimerArm(FakeTimer &t, uint32_t periodUs) {
+    t.running = true;
+    t.periodUs = periodUs;
+    t.next = nowUs + periodUs;
+    t.fireAt = t.next + jitter(t.latencyJitterUs);
+}
+
+uint64_t fakeNextEvent() {
+    uint64_t at = board.uart.nextArrival();
+    if (board.uart.moduleAt() < at) at = board.uart.moduleAt();
+    if (board.rtc.alarmAt() < at) at = board.rtc.alarmAt();
+    for (int i = 0; i < FAKE_TIMERS; i++) {
+        const FakeTimer &ft = board.timers[i];
+        if (ft.running && ft.fireAt < at) at = ft.fireAt;
+    }
+    return at;
+}
+
+// Обработка событий (приход байт по UART, прерывания таймеров) в порядке времени
+void fakeAdvanceTo(uint64_t t) {
+    for (;;) {
+        uint64_t at = board.uart.nextArrival();
+        int timer = -1;
+        bool rtc = false;
+        if (board.rtc.alarmAt() < at) {
+            at = board.rtc.alarmAt();
+            rtc = true;
+        }
+        for (int i = 0; i < FAKE_TIMERS; i++) {
+            const FakeTimer &ft = board.timers[i];
+            if (ft.running && ft.fireAt < at) {
+                at = ft.fireAt;
+                timer = i;
+                rtc = false;
+            }
+        }
+        if (board.uart.moduleAt() < at && board.uart.moduleAt() <= t) {
+            if (board.uart.moduleAt() > nowUs) nowUs = board.uart.moduleAt();
+            board.uart.moduleService();
+            continue;
+        }
+        if (at > t) break;
+        if (at > nowUs) nowUs = at;
+
+        if (rtc) {
+            board.rtc.fireAlarm();
+            continue;
+        }
+        if (timer < 0) {
+            board.uart.deliver(nowUs);
+            continue;
+        }
+        FakeTimer &ft = board.timers[timer];
+        ft.fires++;
+        ft.isr();
+        // isr мог остановить таймер или сменить период
+        if (ft.running && ft.fireAt == at) {
+            ft.next += ft.periodUs;
+            ft.fireAt = ft.next + jitter(ft.latencyJitterUs);
+        }
+    }
+    if (t > nowUs) nowUs = t;
+}
+
+void fakeAdvance(uint64_t us) {
+    fakeAdvanceTo(nowUs + us);
+}
+
+void fakeReset() {
+    nowUs = 0;
+    jitterSeed = 1;
+    board = FakeBoard();
+    board.bus.attach(0x68, &board.rtc);
+    board.bus.attach(0x57, &board.eeprom);
+}
+
+// ---------------------------------------------------------------- I2C
+
+void FakeI2cBus::attach(uint8_t addr, FakeI2cDevice *dev) {
+    devices_[addr & 0x7F] = dev;
+}
+
+void FakeI2cBus::spend(size_t bytes) {
+    // START/STOP + 9 тактов SCL на каждый байт
+    fakeAdvance(10 + bytes * 9 * 1000000ULL / clockHz);
+}
+
+uint8_t FakeI2cBus::write(uint8_t addr, const uint8_t *data, size_t len, bool stop) {
+    (void)stop;
+    stats.transactions++;
+    FakeI2cDevice *dev = devices_[addr & 0x7F];
+    if (!dev || !dev->ready()) {
+        spend(1);
+        stats.bytes++;
+        stats.nacks++;
+        return 2;  // NACK на адрес, как Wire.endTransmission
+    }
+    spend(len + 1);
+    stats.bytes += len + 1;
+    return dev->write(data, len) ? 0 : 3;
+}
+
+size_t FakeI2cBus::read(uint8_t addr, uint8_t *buf, size_t len) {
+    stats.transactions++;
+    FakeI2cDevice *dev = devices_[addr & 0x7F];
+    if (!dev || !dev->ready()) {
+        spend(1);
+        stats.bytes++;
+        stats.nacks++;
+        return 0;
+    }
+    spend(len + 1);
+    stats.bytes += len + 1;
+    return dev->read(buf, len);
+}
+
+// ---------------------------------------------------------------- DS3231
+
+FakeDS3231::FakeDS3231() {
+    for (size_t i = 0; i < sizeof(regs_); i++) regs_[i] = 0;
+    regs_[0x0E] = 0x1C;  // Значение регистра управления после подачи питания
+    regs_[0x0F] = 0x80;  // OSF: генератор останавливался
+    latch();
+}
+
+int64_t FakeDS3231::epoch() const {
+    double elapsed = (double)(fakeNow() - baseUs_) * (1.0 + driftPpm * 1e-6);
+    return baseSeconds_ + (int64_t)floor(elapsed / 1e6);
+}
+
+void FakeDS3231::setEpoch(int64_t seconds) {
+    baseSeconds_ = seconds;
+    baseUs_ = fakeNow();
+    latch();
+    planAlarm();
+}
+
+// Момент по виртуальным часам, когда часы покажут seconds
+uint64_t FakeDS3231::toUs(int64_t seconds) const {
+    double us = (double)(seconds - baseSeconds_) * 1e6 / (1.0 + driftPpm * 1e-6);
+    return baseUs_ + (uint64_t)ceil(us);
+}
+
+void FakeDS3231::planAlarm() {
+    alarmAt_ = UINT64_MAX;
+    bool enabled = (regs_[0x0E] & 0x05) == 0x05;             // INTCN | A1IE
+    bool dailyMode = (regs_[0x0A] & 0x80) && !(regs_[0x07] & 0x80) &&
+                     !(regs_[0x08] & 0x80) && !(regs_[0x09] & 0x80);
+    if (!enabled || !dailyMode) return;
+
+    int64_t target = fromBcd(regs_[0x09] & 0x3F) * 3600 + fromBcd(regs_[0x08]) * 60 + fromBcd(regs_[0x07]);
+    int64_t now = epoch();
+    int64_t ahead = ((target - now % 86400) % 86400 + 86400) % 86400;
+    if (ahead == 0) ahead = 86400;
+    alarmAt_ = toUs(now + ahead);
+}
+
+void FakeDS3231::fireAlarm() {
+    alarms++;
+    regs_[0x0F] |= 0x01;
+    if (intPin >= 0) board.pins[intPin].level = false;
+    alarmAt_ = toUs(epoch() + 86400);
+}
+
+// Перенос текущего времени в регистры 0x00..0x06
+void FakeDS3231::latch() {
+    int64_t t = epoch();
+    int64_t days = t / 86400;
+    int64_t sec = t % 86400;
+    int64_t y;
+    unsigned m, d;
+    civilFromDays(days + EPOCH_2000, y, m, d);
+
+    regs_[0x00] = toBcd((unsigned)(sec % 60));
+    regs_[0x01] = toBcd((unsigned)(sec / 60 % 60));
+    regs_[0x02] = toBcd((unsigned)(sec / 3600));
+    regs_[0x03] = (uint8_t)((days + 5) % 7 + 1);  // 1 = понедельник, 2000-01-01 — суббота
+    regs_[0x04] = toBcd(d);
+    regs_[0x05] = toBcd(m);
+    regs_[0x06] = toBcd((unsigned)(y - 2000));
+}
+
+// Пересчёт хода часов из записанных регистров 0x00..0x06
+void FakeDS3231::commit() {
+    unsigned sec = fromBcd(regs_[0x00] & 0x7F);
+    unsigned min = fromBcd(regs_[0x01] & 0x7F);
+    unsigned hour = fromBcd(regs_[0x02] & 0x3F);
+    unsigned d = fromBcd(regs_[0x04] & 0x3F);
+    unsigned m = fromBcd(regs_[0x05] & 0x1F);
+    unsigned y = fromBcd(regs_[0x06]) + 2000;
+    if (m < 1) m = 1;
+    if (d < 1) d = 1;
+    int64_t days = daysFromCivil(y, m, d) - EPOCH_2000;
+    baseSeconds_ = days * 86400 + hour * 3600 + min * 60 + sec;
+    baseUs_ = fakeNow();
+}
+
+bool FakeDS3231::write(const uint8_t *data, size_t len) {
+    if (len == 0) return true;
+    latch();
+    pointer_ = data[0] % sizeof(regs_);
+    bool timeTouched = false;
+    bool alarmTouched = false;
+    for (size_t i = 1; i < len; i++) {
+        if (pointer_ <= 0x06) timeTouched = true;
+        if (pointer_ >= 0x07 && pointer_ <= 0x0E) alarmTouched = true;
+        if (pointer_ == 0x0F) {
+            // Флаги OSF, A2F, A1F можно только сбросить, EN32kHz — записать
+            regs_[0x0F] = (regs_[0x0F] & data[i] & 0x83) | (data[i] & 0x08) | (regs_[0x0F] & 0x04);
+            if (!(regs_[0x0F] & 0x01) && intPin >= 0) board.pins[intPin].level = true;
+        } else {
+            regs_[pointer_] = data[i];
+        }
+        pointer_ = (pointer_ + 1) % sizeof(regs_);
+    }
+    if (timeTouched) commit();
+    if (timeTouched || alarmTouched) planAlarm();
+    return true;
+}
+
+size_t FakeDS3231::read(uint8_t *buf, size_t len) {
+    latch();
+    for (size_t i = 0; i < len; i++) {
+        buf[i] = regs_[pointer_];
+        pointer_ = (pointer_ + 1) % sizeof(regs_);
+    }
+    return len;
+}
+
+// ---------------------------------------------------------------- EEPROM
+
+FakeEeprom::FakeEeprom(size_t size, size_t page)
+    : mem(size, 0xFF), cellWrites(size, 0), page_(page) {}
+
+bool FakeEeprom::ready() {
+    return fakeNow() >= busyUntil_;
+}
+
+bool FakeEeprom::write(const uint8_t *data, size_t len) {
+    if (len < 2) return true;
+    pointer_ = (uint16_t)(((data[0] << 8) | data[1]) % mem.size());
+    if (len == 2) return true;  // Только установка адреса для чтения
+
+    // Запись в пределах страницы: адрес заворачивается на её начало
+    size_t pageStart = pointer_ - pointer_ % page_;
+    size_t offset = pointer_ % page_;
+    for (size_t i = 2; i < len; i++) {
+        size_t cell = pageStart + offset;
+        mem[cell] = data[i];
+        cellWrites[cell]++;
+        offset = (offset + 1) % page_;
+    }
+    pageWrites++;
+    busyUntil_ = fakeNow() + writeCycleUs;
+    return true;
+}
+
+size_t FakeEeprom::read(uint8_t *buf, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        buf[i] = mem[pointer_];
+        pointer_ = (uint16_t)((pointer_ + 1) % mem.size());
+    }
+    return len;
+}
+
+// ---------------------------------------------------------------- UART
+
+void FakeUart::feed(const uint8_t *data, size_t len, uint64_t atUs) {
+    uint64_t t = atUs > lineFreeAt_ ? atUs : lineFreeAt_;
+    for (size_t i = 0; i < len; i++) {
+        t += byteTimeUs();
+        pending_.push_back(Arrival{t, data[i]});
+    }
+    lineFreeAt_ = t;
+}
+
+uint64_t FakeUart::nextArrival() const {
+    return pending_.empty() ? UINT64_MAX : pending_.front().at;
+}
+
+void FakeUart::deliver(uint64_t now) {
+    while (!pending_.empty() && pending_.front().at <= now) {
+        if (onRx && !coreRx) onRx(pending_.front().byte);
+        else rx.push_back(pending_.front().byte);
+        pending_.pop_front();
+    }
+}
+
+bool FakeUart::txReady() const {
+    uint64_t now = fakeNow();
+    if (txLineFreeAt_ <= now) return true;
+    uint64_t queued = (txLineFreeAt_ - now + byteTimeUs() - 1) / byteTimeUs();
+    return queued < txFifoSize;
+}
+
+void FakeUart::txPut(uint8_t b) {
+    uint64_t now = fakeNow();
+    txLineFreeAt_ = (txLineFreeAt_ > now ? txLineFreeAt_ : now) + byteTimeUs();
+    tx.push_back(b);
+
+    // Модуль копит команду до паузы в передаче
+    if (connected) return;
+    if (baud_ != moduleBaud) atGarbled_ = true;
+    at_.push_back(b);
+    moduleAt_ = txLineFreeAt_ + atGapUs;
+}
+
+static bool atIs(const std::vector<uint8_t> &cmd, const char *text) {
+    return cmd.size() == strlen(text) && memcmp(cmd.data(), text, cmd.size()) == 0;
+}
+
+void FakeUart::moduleService() {
+    static const uint32_t rates[] = {9600, 19200, 38400, 57600, 115200};   // Коды AT+BAUD0..4
+    uint64_t now = fakeNow();
+    std::vector<uint8_t> cmd;
+    cmd.swap(at_);
+    bool garbled = atGarbled_;
+    atGarbled_ = false;
+    moduleAt_ = UINT64_MAX;
+    if (now < moduleBusyUntil_ || garbled || cmd.size() < 2 || cmd[0] != 'A' || cmd[1] != 'T') return;
+    atCommands++;
+
+    char reply[16] = "";
+    bool reset = false;
+    if (atIs(cmd, "AT")) {
+        strcpy(reply, "OK");
+    } else if (atIs(cmd, "AT+BAUD?")) {
+        for (unsigned i = 0; i < 5; i++) {
+            if (rates[i] == moduleBaud) snprintf(reply, sizeof(reply), "OK+Get:%u", i);
+        }
+    } else if (baudCommand && cmd.size() == 8 && memcmp(cmd.data(), "AT+BAUD", 7) == 0 && cmd[7] >= '0' && cmd[7] <= '4') {
+        pendingBaud_ = rates[cmd[7] - '0'];
+        snprintf(reply, sizeof(reply), "OK+Set:%c", cmd[7]);
+    } else if (atIs(cmd, "AT+RESET")) {
+        strcpy(reply, "OK+RESET");
+        reset = true;
+    }
+    if (reply[0]) feed((const uint8_t *)reply, strlen(reply), now);
+
+    // Новая скорость действует после перезапуска
+    if (reset) {
+        moduleBusyUntil_ = now + resetUs;
+        if (pendingBaud_) moduleBaud = pendingBaud_;
+        pendingBaud_ = 0;
+    }
+}
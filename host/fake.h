@@ -0,0 +1,204 @@
+#ifndef fake_h
+#define fake_h
+
+// Поддельные устройства для нативной сборки: виртуальные часы, шина I2C
+// с DS3231 и EEPROM 24Cxx, UART со сценарием входящих байт и выводы GPIO.
+// Время виртуальное: оно продвигается задержками, передачей байт по шинам
+// и явными вызовами fakeAdvance(), поэтому замеры не зависят от хоста.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <deque>
+#include <vector>
+
+// Виртуальные часы, микросекунды от старта
+uint64_t fakeNow();
+void fakeAdvance(uint64_t us);
+void fakeAdvanceTo(uint64_t t);
+uint64_t fakeNextEvent();           // Ближайшее прерывание: байт UART, будильник, таймер; UINT64_MAX — нет
+
+// Счётчики шины I2C
+struct I2cStats {
+    uint32_t transactions;  // Количество транзакций (START ... STOP/повторный START)
+    uint32_t bytes;         // Количество переданных байт, включая байт адреса
+    uint32_t nacks;         // Транзакции, не подтверждённые устройством
+};
+
+// Устройство на шине I2C
+class FakeI2cDevice {
+public:
+    virtual ~FakeI2cDevice() {}
+    virtual bool ready() { return true; }                     // false = устройство не отвечает на адрес
+    virtual bool write(const uint8_t *data, size_t len) = 0;  // false = NACK
+    virtual size_t read(uint8_t *buf, size_t len) = 0;
+};
+
+// Шина I2C, 100 кГц: каждый байт занимает 9 тактов SCL
+class FakeI2cBus {
+public:
+    void attach(uint8_t addr, FakeI2cDevice *dev);
+    uint8_t write(uint8_t addr, const uint8_t *data, size_t len, bool stop);
+    size_t read(uint8_t addr, uint8_t *buf, size_t len);
+
+    I2cStats stats = {};
+    uint32_t clockHz = 100000;
+
+private:
+    void spend(size_t bytes);
+    FakeI2cDevice *devices_[128] = {};
+};
+
+// Часы реального времени DS3231
+class FakeDS3231 : public FakeI2cDevice {
+public:
+    FakeDS3231();
+    bool write(const uint8_t *data, size_t len) override;
+    size_t read(uint8_t *buf, size_t len) override;
+
+    // Установка времени в обход шины (секунды от 2000-01-01 00:00:00)
+    void setEpoch(int64_t seconds);
+    int64_t epoch() const;
+
+    // Alarm 1 в режиме совпадения часов, минут и секунд (A1M4 = 1):
+    // момент срабатывания по виртуальным часам или UINT64_MAX
+    uint64_t alarmAt() const { return alarmAt_; }
+    void fireAlarm();               // Установить A1F и опустить INT
+
+    // Флаг OSF: генератор останавливался (как после включения без батареи)
+    void stopOscillator() { regs_[0x0F] |= 0x80; }
+    bool oscillatorStopped() const { return regs_[0x0F] & 0x80; }
+
+    double driftPpm = 0;  // Уход хода кварца, ppm
+    int intPin = -1;      // Вывод платы, к которому подключён INT
+    uint32_t alarms = 0;  // Количество срабатываний Alarm 1
+
+private:
+    void latch();
+    void commit();
+    void planAlarm();
+    uint64_t toUs(int64_t seconds) const;
+
+    uint8_t regs_[0x13];
+    uint8_t pointer_ = 0;
+    int64_t baseSeconds_ = 0;  // Время в момент baseUs_
+    uint64_t baseUs_ = 0;
+    uint64_t alarmAt_ = UINT64_MAX;
+};
+
+// EEPROM 24Cxx со страничной записью и циклом записи tWR,
+// во время которого микросхема не подтверждает свой адрес
+class FakeEeprom : public FakeI2cDevice {
+public:
+    FakeEeprom(size_t size = 4096, size_t page = 32);
+    bool ready() override;
+    bool write(const uint8_t *data, size_t len) override;
+    size_t read(uint8_t *buf, size_t len) override;
+
+    std::vector<uint8_t> mem;
+    std::vector<uint32_t> cellWrites;  // Количество циклов записи каждой ячейки
+    uint32_t pageWrites = 0;           // Количество циклов записи страниц
+    uint32_t writeCycleUs = 3500;      // Длительность цикла записи tWR
+
+private:
+    size_t page_;
+    uint16_t pointer_ = 0;
+    uint64_t busyUntil_ = 0;
+};
+
+// UART модуля BLE: входящие байты приходят по сценарию со скоростью линии,
+// исходящие уходят из FIFO передатчика на 16 байт с той же скоростью.
+// На другом конце — модуль HM-10: без соединения он понимает AT-команды
+// (байты без перевода строки, конец команды — пауза atGapUs) и отвечает
+// на них; байты на скорости, отличной от moduleBaud, он не разбирает
+class FakeUart {
+public:
+    static const size_t txFifoSize = 16;
+
+    void begin(uint32_t baud) { baud_ = baud; }
+    uint32_t baud() const { return baud_; }
+    // Поставить байты в очередь приёма начиная с момента atUs
+    void feed(const uint8_t *data, size_t len, uint64_t atUs);
+    void feed(const uint8_t *data, size_t len) { feed(data, len, fakeNow()); }
+
+    uint64_t byteTimeUs() const { return 10000000ULL / baud_; }
+    uint64_t nextArrival() const;  // UINT64_MAX, если ожидать нечего
+    void deliver(uint64_t now);    // Перенести пришедшие байты в приёмный буфер
+
+    bool txReady() const;          // В FIFO передатчика есть место
+    void txPut(uint8_t b);
+    bool txDone() const { return txLineFreeAt_ <= fakeNow(); }
+    uint64_t txLineFreeAt() const { return txLineFreeAt_; }  // Конец передачи последнего байта
+
+    uint64_t moduleAt() const { return moduleAt_; }  // Разбор AT-команды; UINT64_MAX — нечего
+    void moduleService();          // Ответить на принятую AT-команду
+
+    std::deque<uint8_t> rx;        // Приёмный буфер ядра
+    void (*onRx)(uint8_t) = nullptr; // Прерывание приёма; если задано, rx не заполняется
+    bool coreRx = false;           // Прерывание приёма у ядра: rx заполняется и при onRx
+    std::vector<uint8_t> tx;       // Отправленные байты
+    uint32_t readTimeoutMs = 1000; // Тайм-аут Stream::readBytes
+
+    uint32_t moduleBaud = 9600;    // Скорость модуля, хранится в его flash
+    bool baudCommand = true;       // false — прошивка модуля не знает AT+BAUD
+    bool connected = false;        // При соединении AT-команды уходят в телефон
+    uint32_t atGapUs = 10000;      // Пауза, завершающая AT-команду
+    uint32_t resetUs = 500000;     // Перезапуск модуля после AT+RESET
+    uint32_t atCommands = 0;       // Принятые модулем AT-команды
+
+private:
+    struct Arrival { uint64_t at; uint8_t byte; };
+    std::deque<Arrival> pending_;
+    uint64_t lineFreeAt_ = 0;
+    uint64_t txLineFreeAt_ = 0;
+    uint32_t baud_ = 9600;
+
+    std::vector<uint8_t> at_;      // Накопленная AT-команда
+    bool atGarbled_ = false;       // Часть команды пришла на чужой скорости
+    uint64_t moduleAt_ = UINT64_MAX;
+    uint64_t moduleBusyUntil_ = 0;
+    uint32_t pendingBaud_ = 0;     // Скорость после перезапуска
+};
+
+// Выводы GPIO
+struct FakePin {
+    bool output = false;
+    bool level = false;
+    uint32_t edges = 0;                // Количество переключений
+    bool trace = false;                // Записывать моменты переключений
+    std::vector<uint64_t> edgeTimes;
+};
+
+#define FAKE_TIMERS 3               // HAL_TIMER_MOTION, HAL_TIMER_UART, HAL_TIMER_SOUND
+
+// Аппаратный таймер: вызывает isr каждые periodUs микросекунд.
+// Вход в прерывание может запаздывать на случайные 0..latencyJitterUs мкс,
+// при этом сам таймер не сбивается с периода
+struct FakeTimer {
+    bool running = false;
+    uint32_t periodUs = 0;
+    uint64_t next = 0;                 // Номинальный момент срабатывания
+    uint64_t fireAt = 0;               // Фактический вход в прерывание
+    void (*isr)() = nullptr;
+    uint32_t fires = 0;                // Количество вызовов isr
+    uint32_t latencyJitterUs = 0;
+};
+
+// Набор поддельных устройств стенда
+struct FakeBoard {
+    FakeI2cBus bus;
+    FakeDS3231 rtc;
+    FakeEeprom eeprom;
+    FakeUart uart;
+    FakePin pins[64];
+    FakeTimer timers[FAKE_TIMERS];
+};
+
+extern FakeBoard board;
+
+// Сброс стенда в начальное состояние
+void fakeReset();
+
+// Взвод таймера: первое срабатывание через periodUs от текущего момента
+void fakeTimerArm(FakeTimer &t, uint32_t periodUs);
+
+#endif
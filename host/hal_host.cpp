@@ -0,0 +1,154 @@
+#include "hal.h"
+
+#include "config.h"
+#include "fake.h"
+
+void halI2cBegin() {
+    board.bus.clockHz = I2C_CLOCK_HZ;
+}
+
+uint8_t halI2cWrite(uint8_t addr, const uint8_t *data, size_t len, bool stop) {
+    return board.bus.write(addr, data, len, stop);
+}
+
+size_t halI2cRead(uint8_t addr, uint8_t *buf, size_t len) {
+    return board.bus.read(addr, buf, len);
+}
+
+void halUartBegin(uint32_t baud) {
+    board.uart.begin(baud);
+}
+
+int halUartAvailable() {
+    return (int)board.uart.rx.size();
+}
+
+int halUartRead() {
+    if (board.uart.rx.empty()) return -1;
+    uint8_t b = board.uart.rx.front();
+    board.uart.rx.pop_front();
+    return b;
+}
+
+// Как Stream::readBytes: ждёт каждый байт не дольше тайм-аута
+size_t halUartReadBytes(uint8_t *buf, size_t len) {
+    size_t n = 0;
+    while (n < len) {
+        if (board.uart.rx.empty()) {
+            uint64_t deadline = fakeNow() + board.uart.readTimeoutMs * 1000ULL;
+            uint64_t next = board.uart.nextArrival();
+            fakeAdvanceTo(next < deadline ? next : deadline);
+            if (board.uart.rx.empty()) break;
+        }
+        buf[n++] = board.uart.rx.front();
+        board.uart.rx.pop_front();
+    }
+    return n;
+}
+
+// Как Serial1.write ядра: байт за байтом со скоростью линии
+size_t halUartWrite(const uint8_t *data, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        if (!board.uart.txReady()) fakeAdvanceTo(board.uart.txLineFreeAt() - (FakeUart::txFifoSize - 1) * board.uart.byteTimeUs());
+        board.uart.txPut(data[i]);
+    }
+    fakeAdvanceTo(board.uart.txLineFreeAt());
+    return len;
+}
+
+bool halUartTxReady() {
+    return board.uart.txReady();
+}
+
+void halUartTxPut(uint8_t b) {
+    board.uart.txPut(b);
+}
+
+bool halUartTxDone() {
+    return board.uart.txDone();
+}
+
+void halUartAttachRx(HalRxCallback cb) {
+    board.uart.onRx = cb;
+}
+
+// Поддельный UART вызывает обработчик сам в момент прихода байта. При
+// coreRx байты копит буфер ядра, и они переносятся так же, как в hal.cpp
+size_t halUartService(size_t room) {
+    FakeUart &u = board.uart;
+    if (!u.onRx) return 0;
+    size_t n = 0;
+    while (n < room && !u.rx.empty()) {
+        u.onRx(u.rx.front());
+        u.rx.pop_front();
+        n++;
+    }
+    return n;
+}
+
+void halPinOutput(uint8_t pin) {
+    board.pins[pin].output = true;
+}
+
+void halPinWrite(uint8_t pin, bool value) {
+    FakePin &p = board.pins[pin];
+    if (p.level != value) {
+        p.edges++;
+        if (p.trace) p.edgeTimes.push_back(fakeNow());
+    }
+    p.level = value;
+}
+
+void halPinInputPullup(uint8_t pin) {
+    board.pins[pin].output = false;
+    board.pins[pin].level = true;
+}
+
+bool halPinRead(uint8_t pin) {
+    return board.pins[pin].level;
+}
+
+void halTimerStart(uint8_t timer, uint32_t periodUs, HalTimerCallback isr) {
+    board.timers[timer].isr = isr;
+    fakeTimerArm(board.timers[timer], periodUs);
+}
+
+void halTimerSetPeriod(uint8_t timer, uint32_t periodUs) {
+    board.timers[timer].periodUs = periodUs;
+}
+
+void halTimerStop(uint8_t timer) {
+    board.timers[timer].running = false;
+}
+
+uint32_t halMillis() {
+    return (uint32_t)(fakeNow() / 1000);
+}
+
+uint32_t halMicros() {
+    return (uint32_t)fakeNow();
+}
+
+void halDelayMs(uint32_t ms) {
+    fakeAdvance(ms * 1000ULL);
+}
+
+void halDelayUs(uint32_t us) {
+    fakeAdvance(us);
+}
+
+// WFI: время идёт до ближайшего прерывания стенда, но не дольше maxUs
+void halSleepUs(uint32_t maxUs) {
+    uint64_t until = fakeNow() + maxUs;
+    uint64_t at = fakeNextEvent();
+    fakeAdvanceTo(at < until ? at : until);
+}
+
+void halCyclesBegin() {
+}
+
+// Виртуальное время в тактах ядра: видны ожидания шин и задержки,
+// а не работа процессора на хосте
+uint32_t halCycles() {
+    return (uint32_t)(fakeNow() * (CPU_HZ / 1000000));
+}
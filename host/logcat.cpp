@@ -0,0 +1,23 @@
+// Перевод двоичного журнала с отладочного порта платы в текст.
+// Поток читается со стандартного входа, например:
+//   stty -F /dev/ttyUSB0 115200 raw && logcat < /dev/ttyUSB0
+// Порт нужно открыть до запуска платы: запись не найти с середины потока.
+
+#include <stdio.h>
+#include <string>
+
+#include "logdecode.h"
+
+int main() {
+    LogDecoder decoder;
+    uint8_t buf[256];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), stdin)) > 0) {
+        std::string text;
+        decoder.feed(buf, n, text);
+        fwrite(text.data(), 1, text.size(), stdout);
+        fflush(stdout);
+    }
+    if (decoder.unknown) fprintf(stderr, "%u bytes with unknown event\n", decoder.unknown);
+    return 0;
+}
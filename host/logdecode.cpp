@@ -0,0 +1,73 @@
+#include "logdecode.h"
+
+#include <stdio.h>
+
+#include "log.h"
+
+static const char *const texts[] = {
+#define LOG_TEXT(name, level, args, text) text,
+    LOG_EVENTS(LOG_TEXT)
+#undef LOG_TEXT
+};
+
+// Число LEB128 с позиции pos; false — запись ещё не пришла целиком
+static bool getVarint(const std::vector<uint8_t> &buf, size_t &pos, uint32_t &v) {
+    v = 0;
+    for (uint8_t shift = 0; shift < 35; shift += 7) {
+        if (pos >= buf.size()) return false;
+        uint8_t b = buf[pos++];
+        v |= (uint32_t)(b & 0x7F) << shift;
+        if (!(b & 0x80)) return true;
+    }
+    return true;
+}
+
+// Одна запись с начала необработанных байт
+bool LogDecoder::decode(std::string &out) {
+    size_t pos = pos_;
+    if (pos >= pending_.size()) return false;
+    uint8_t event = pending_[pos++];
+    if (event >= LOG_EVENT_COUNT) {
+        unknown++;
+        pos_ = pos;
+        return true;
+    }
+
+    uint32_t dt, args[LOG_MAX_ARGS];
+    if (!getVarint(pending_, pos, dt)) return false;
+    for (uint8_t i = 0; i < logArgs[event]; i++) {
+        if (!getVarint(pending_, pos, args[i])) return false;
+    }
+    pos_ = pos;
+    ms_ += dt;
+
+    char line[160];
+    int n = snprintf(line, sizeof(line), "[%5u.%03u] ", ms_ / 1000, ms_ % 1000);
+    uint8_t arg = 0;
+    for (const char *t = texts[event]; *t && n < (int)sizeof(line) - 16; t++) {
+        if (*t != '%' || !t[1]) {
+            line[n++] = *t;
+            continue;
+        }
+        t++;
+        uint32_t v = arg < logArgs[event] ? args[arg] : 0;
+        switch (*t) {
+            case 'u': n += snprintf(line + n, sizeof(line) - n, "%u", v); arg++; break;
+            case 'd': n += snprintf(line + n, sizeof(line) - n, "%d", (int32_t)v); arg++; break;
+            case 'x': n += snprintf(line + n, sizeof(line) - n, "%X", v); arg++; break;
+            default: line[n++] = *t; break;
+        }
+    }
+    line[n++] = '\n';
+    out.append(line, n);
+    return true;
+}
+
+size_t LogDecoder::feed(const uint8_t *data, size_t len, std::string &out) {
+    pending_.insert(pending_.end(), data, data + len);
+    size_t records = 0;
+    while (decode(out)) records++;
+    pending_.erase(pending_.begin(), pending_.begin() + pos_);
+    pos_ = 0;
+    return records;
+}
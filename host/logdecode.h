@@ -0,0 +1,30 @@
+#ifndef logdecode_h
+#define logdecode_h
+
+// Декодер двоичного журнала скетча (log.h) в текст.
+// Тексты событий берутся из той же таблицы LOG_EVENTS, что и в прошивке,
+// поэтому декодер собирается вместе с нативной сборкой скетча.
+// Поток подаётся кусками любого размера; каждая целая запись даёт строку
+// «[секунды.мс] текст».
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+#include <vector>
+
+class LogDecoder {
+public:
+    // Разобрать очередные байты, дописать строки в out; возвращает число записей
+    size_t feed(const uint8_t *data, size_t len, std::string &out);
+
+    uint32_t unknown = 0;   // Байты с неизвестным номером события (поток начат не с записи)
+
+private:
+    bool decode(std::string &out);
+
+    std::vector<uint8_t> pending_;
+    size_t pos_ = 0;
+    uint32_t ms_ = 0;
+};
+
+#endif
@@ -0,0 +1,455 @@
+// Симулятор многолетней работы кормушки на поддельных устройствах.
+// Скетч крутит loop() со сном между событиями: idleSleep() переводит
+// виртуальные часы прямо к следующему событию — байту UART, будильнику
+// DS3231, прерыванию таймера шагов или сроку планировщика, — поэтому десять
+// лет проходят за секунды, а не за десять лет.
+//
+// Сценарий случайный, но повторяемый по seed: приложение правит расписание
+// и сверяет время, по BLE идут пакетные штормы (мусор, неполные кадры,
+// запросы чтения), питание пропадает, иногда вместе с батареей часов —
+// тогда DS3231 встаёт с OSF, скетч ставит время сборки, пока приложение не
+// пришлёт верное. Часы уходят на RTC_DRIFT_PPM.
+//
+// Оракул ведёт свою копию расписания и проверяет каждое кормление по
+// времени DS3231: срабатывание должно прийти в [срок - 1 с, срок + 2 с],
+// одно на срок. Исключение — срок в начале минуты, в которой изменилось
+// расписание или время: скетч может выполнить его с опозданием, но один раз.
+// Срок, через который часы прошли непрерывно, без кормления — пропуск.
+// Около скачков времени (SIM_MARGIN_S) пропуск не засчитывается: куда
+// попадёт срок, решает момент скачка.
+//
+// Память скетча при отключении питания не обнуляется: после включения
+// состояние модулей восстанавливают их функции *Begin() из setup().
+//
+//   sim [лет] [seed] [--int] [--trace файл]
+// --int — будильник DS3231 на выводе INT (SIM_INT_PIN), иначе срок по millis().
+// Трасса — CSV: истинное время, время DS3231, задача, срок, порции,
+// отклонение, отметка (ok, dup, late, spurious, missed).
+// Код возврата 1, если найдено хоть одно нарушение.
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <map>
+#include <utility>
+#include <vector>
+
+#include "Arduino.h"
+#include "bus.h"
+#include "calendar.h"
+#include "check.h"
+#include "config.h"
+#include "crc.h"
+#include "fake.h"
+#include "framer.h"
+#include "hal.h"
+#include "idle.h"
+#include "main.h"
+#include "motion.h"
+#include "scheduler.h"
+#include "store.h"
+#include "sync.h"
+#include "tasks.h"
+#include "time.h"
+
+#define SIM_INT_PIN 2
+#define SIM_SLOTS 16                // Задач в расписании приложения
+#define SIM_EARLY_S 1               // Программные часы могут опередить DS3231 на секунду
+#define SIM_LATE_S 2                // Допустимое опоздание кормления
+#define SIM_MARGIN_S 2              // Окрестность скачка времени без проверки пропусков
+#define SIM_REPLY_GAP_US 500000     // Ожидание ответа на запрос в шторме
+#define SIM_DUP_S 86400             // Повтор того же срока раньше, чем через сутки — дубль
+#define RTC_DRIFT_PPM 15            // Уход кварца DS3231
+
+// Средние интервалы сценария, секунды
+#define SIM_EDIT_S (20 * 86400.0)
+#define SIM_SYNC_S (7 * 86400.0)
+#define SIM_STORM_S (3 * 86400.0)
+#define SIM_POWER_S (60 * 86400.0)
+#define SIM_OUTAGE_S (6 * 3600.0)
+#define SIM_RECONNECT_S (12 * 3600.0)
+
+static const uint32_t trueStart = epochFromCivil(2025, 1, 1, 0, 0, 0);   // Истинное время в начале
+
+static uint32_t seed = 1;
+static uint32_t rnd() {
+    seed = seed * 1103515245 + 12345;
+    return seed >> 8;
+}
+
+// Случайный интервал с экспоненциальным распределением, мкс
+static uint64_t expUs(double meanS) {
+    double u = (rnd() % 1000000 + 1) / 1000001.0;
+    return (uint64_t)(-meanS * log(u) * 1e6);
+}
+
+static uint32_t trueNow() {
+    return trueStart + (uint32_t)(fakeNow() / 1000000);
+}
+
+// Время DS3231 через dt мкс, без учёта скачков
+static uint32_t rtcIn(uint64_t dt) {
+    return (uint32_t)board.rtc.epoch() + (uint32_t)(dt * (1.0 + board.rtc.driftPpm * 1e-6) / 1e6);
+}
+
+static void printTime(FILE *f, uint32_t epoch) {
+    DateTime t = fromEpoch(epoch);
+    fprintf(f, "%04u-%02u-%02u %02u:%02u:%02u", t.year, t.month, t.date, t.hours, t.minutes, t.seconds);
+}
+
+// ---------------------------------------------------------------- оракул
+
+static std::vector<TaskEntry> model(MAX_TASK, TASK_FREE);
+static std::map<std::pair<uint8_t, uint32_t>, uint32_t> firedAt;   // (задача, срок) -> истинное время
+static uint32_t windowFrom = 0;     // Время DS3231 начала отрезка без скачков
+static bool windowMargin = true;    // Отрезок начался скачком
+static FILE *trace = nullptr;
+
+struct Counts {
+    uint32_t feeds, ok, missed, duplicates, late, spurious, wrongClock;
+    uint64_t steps;                 // Ожидаемые шаги двигателя
+    uint32_t edits, lostEdits, syncs, storms, stormBytes, outages, rtcLost;
+};
+static Counts counts;
+
+// Срок задачи e не позже t; 0 — за последнюю неделю сроков нет
+static uint32_t lastDue(TaskEntry e, uint32_t t) {
+    for (int back = 0; back <= 7; back++) {
+        uint32_t day = t / 86400 - back;
+        uint32_t due = day * 86400 + taskMinute(e) * 60UL;
+        if (due > t || !(taskDays(e) & (1 << (weekdayFromDays(day) - 1)))) continue;
+        return due;
+    }
+    return 0;
+}
+
+static void traceLine(uint32_t rtc, uint8_t task, uint32_t due, uint8_t portions, int32_t offset, const char *flag) {
+    if (!trace) return;
+    printTime(trace, trueNow());
+    fputc(',', trace);
+    printTime(trace, rtc);
+    fprintf(trace, ",%u,", task);
+    printTime(trace, due);
+    fprintf(trace, ",%u,%d,%s\n", portions, offset, flag);
+}
+
+// Все сроки отрезка (from, to] должны быть выполнены
+static void closeWindow(uint32_t to, bool margin) {
+    uint32_t from = windowFrom + (windowMargin ? SIM_MARGIN_S : 0);
+    if (margin) to -= SIM_MARGIN_S;
+    for (uint16_t i = 0; i < MAX_TASK && from < to; i++) {
+        TaskEntry e = model[i];
+        if (!taskUsed(e)) continue;
+        for (uint32_t day = from / 86400; day <= to / 86400; day++) {
+            uint32_t due = day * 86400 + taskMinute(e) * 60UL;
+            if (due <= from || due > to || !(taskDays(e) & (1 << (weekdayFromDays(day) - 1)))) continue;
+            if (firedAt.count({(uint8_t)i, due})) continue;
+            counts.missed++;
+            traceLine(to, i, due, taskPortions(e), 0, "missed");
+        }
+    }
+    // Старые записи уже не понадобятся для поиска дублей
+    uint32_t now = trueNow();
+    for (auto it = firedAt.begin(); it != firedAt.end();) {
+        if (now - it->second > 2 * SIM_DUP_S) it = firedAt.erase(it);
+        else ++it;
+    }
+}
+
+static void openWindow(uint32_t from, bool margin) {
+    windowFrom = from;
+    windowMargin = margin;
+}
+
+// ---------------------------------------------------------------- сценарий
+
+enum ActionKind { ACT_EDIT, ACT_SYNC, ACT_STORM, ACT_POWER, ACT_COUNT };
+
+struct Action {
+    uint64_t at;                    // Виртуальное время
+    bool queued;                    // Байты поставлены в UART
+    uint64_t arrived;               // Приход последнего байта
+    uint64_t done;                  // Момент, после которого скетч точно обработал кадры
+    uint32_t rtcAt;                 // Время DS3231 в момент прихода
+    std::vector<std::pair<uint8_t, TaskEntry>> edits;
+};
+static Action actions[ACT_COUNT];
+
+static size_t makeFrame(uint8_t cmd, const uint8_t *payload, uint8_t len, uint8_t *out) {
+    out[0] = FRAME_SOF;
+    out[1] = cmd;
+    out[2] = len;
+    if (len) memcpy(out + 3, payload, len);
+    out[3 + len] = crc8(out + 1, 2 + len);
+    return 4 + len;
+}
+
+// Момент не раньше at, когда на часах DS3231 будет hh:mm:30 — вдали от сроков
+static uint64_t atHalfMinute(uint64_t at) {
+    uint32_t rtc = rtcIn(at - fakeNow());
+    return at + (uint64_t)((90 - rtc % 60) % 60) * 1000000ULL;
+}
+
+static void schedule(ActionKind kind, double meanS) {
+    actions[kind].at = fakeNow() + expUs(meanS);
+    actions[kind].queued = false;
+}
+
+static TaskEntry randomTask() {
+    uint8_t days = rnd() % 10 < 7 ? TASK_EVERY_DAY : (uint8_t)(rnd() % 127 + 1);
+    return taskMake(rnd() % 24, rnd() % 60, days, rnd() % 3 + 1);
+}
+
+// Байты действия ставятся в UART, когда до него меньше часа: дольше скетч не
+// спит, и время DS3231 в момент прихода известно точно. Приём UART — очередь,
+// поэтому действия ставятся по одному в порядке времени
+static void queue(ActionKind kind) {
+    Action &a = actions[kind];
+    std::vector<uint8_t> bytes;
+    uint8_t frame[4 + MAX_PAYLOAD_SIZE];
+
+    if (a.at < fakeNow()) a.at = fakeNow();   // Срок прошёл, пока питания не было
+    if (kind == ACT_EDIT || kind == ACT_SYNC) a.at = atHalfMinute(a.at);
+    a.rtcAt = rtcIn(a.at - fakeNow());
+
+    if (kind == ACT_EDIT) {
+        a.edits.clear();
+        int n = rnd() % 5 + 1;
+        uint8_t first = rnd() % SIM_SLOTS;
+        for (int k = 0; k < n; k++) {
+            // Ячейки в одной правке разные: кадры могут разобраться за
+            // несколько проходов loop(), и промежуточное расписание не
+            // должно отличаться от итогового ничем, кроме ещё не пришедших задач
+            uint8_t slot = (first + k) % SIM_SLOTS;
+            TaskEntry e = rnd() % 10 < 3 ? TASK_FREE : randomTask();
+            a.edits.push_back({slot, e});
+            if (taskUsed(e)) {
+                uint8_t p[5] = {taskHours(e), taskMinutes(e), slot, taskDays(e), taskPortions(e)};
+                bytes.insert(bytes.end(), frame, frame + makeFrame(0x00, p, sizeof(p), frame));
+            } else {
+                bytes.insert(bytes.end(), frame, frame + makeFrame(0x01, &slot, 1, frame));
+            }
+        }
+    } else if (kind == ACT_SYNC) {
+        // Время, которое приложение пришлёт, — истинное на момент прихода последнего байта
+        DateTime t = fromEpoch(trueStart + (uint32_t)((a.at + 14 * board.uart.byteTimeUs()) / 1000000));
+        uint8_t p[6] = {t.seconds, t.minutes, t.hours, t.date, t.month, (uint8_t)(t.year - 2000)};
+        bytes.insert(bytes.end(), frame, frame + makeFrame(0x03, p, sizeof(p), frame));
+    } else {
+        // Шторм: мусор без байта начала кадра, обрывки кадров и запросы чтения.
+        // За обрывком всегда идёт целый кадр: иначе мусор после байта начала
+        // кадра раз в 256 попыток проходит CRC8 и становится случайной командой.
+        // После запроса приложение ждёт ответа SIM_REPLY_GAP_US: скетч отвечает,
+        // не разбирая приём, и поток запросов без пауз переполнил бы буфер
+        uint64_t t = a.at;
+        uint64_t end = a.at + (rnd() % 20 + 1) * 1000000ULL;
+        while (t < end) {
+            bool request = true;
+            bytes.clear();
+            switch (rnd() % 4) {
+                case 0:
+                    for (int k = rnd() % 40 + 1; k > 0; k--) {
+                        uint8_t b = rnd();
+                        bytes.push_back(b == FRAME_SOF ? 0 : b);
+                    }
+                    request = false;
+                    break;
+                case 1: {
+                    size_t n = makeFrame(0x02, nullptr, 0, frame);
+                    bytes.insert(bytes.end(), frame, frame + rnd() % n);
+                    bytes.insert(bytes.end(), frame, frame + n);
+                    break;
+                }
+                case 2: {
+                    uint8_t since[3] = {0, 0, 0};
+                    bytes.insert(bytes.end(), frame, frame + makeFrame(SYNC_DOWNLOAD, since, 3, frame));
+                    break;
+                }
+                default:
+                    bytes.insert(bytes.end(), frame, frame + makeFrame(0x02, nullptr, 0, frame));
+                    break;
+            }
+            board.uart.feed(bytes.data(), bytes.size(), t);
+            t += bytes.size() * board.uart.byteTimeUs() + (request ? SIM_REPLY_GAP_US : 0);
+            counts.stormBytes += bytes.size();
+        }
+        counts.storms++;
+        a.arrived = t;
+    }
+    if (kind != ACT_STORM) {
+        board.uart.feed(bytes.data(), bytes.size(), a.at);
+        a.arrived = a.at + bytes.size() * board.uart.byteTimeUs();
+    }
+    a.done = a.arrived + 100000;
+    a.queued = true;
+}
+
+// Кадры обработаны: оракул принимает изменения
+static void apply(ActionKind kind) {
+    Action &a = actions[kind];
+    if (kind == ACT_EDIT) {
+        closeWindow(a.rtcAt, false);
+        for (const auto &ed : a.edits) model[ed.first] = ed.second;
+        for (const auto &ed : a.edits) {
+            if (tasksGet(ed.first) != model[ed.first]) counts.lostEdits++;
+        }
+        openWindow(a.rtcAt, false);
+        counts.edits++;
+        schedule(ACT_EDIT, SIM_EDIT_S);
+    } else if (kind == ACT_SYNC) {
+        closeWindow(a.rtcAt, true);
+        openWindow((uint32_t)board.rtc.epoch(), true);
+        counts.syncs++;
+        schedule(ACT_SYNC, SIM_SYNC_S);
+    } else {
+        schedule(ACT_STORM, SIM_STORM_S);
+    }
+}
+
+static void applyDone(bool arrived = false) {
+    for (int k = ACT_EDIT; k <= ACT_STORM; k++) {
+        if (actions[k].queued && fakeNow() >= (arrived ? actions[k].arrived : actions[k].done)) apply((ActionKind)k);
+    }
+}
+
+// ---------------------------------------------------------------- скетч
+
+static int8_t intPin = -1;
+
+static void onFeed(uint8_t i) {
+    applyDone(true);    // Кормление после кадров — уже по новому расписанию
+    uint32_t rtc = (uint32_t)board.rtc.epoch();
+    TaskEntry e = model[i];
+    counts.feeds++;
+    int32_t skew = (int32_t)(rtc - trueNow());
+    if (skew < -60 || skew > 60) counts.wrongClock++;
+
+    uint32_t due = taskUsed(e) ? lastDue(e, rtc + SIM_EARLY_S) : 0;
+    const char *flag = "ok";
+    if (!due || rtc + SIM_EARLY_S < due) {
+        flag = "spurious";
+        counts.spurious++;
+    } else {
+        auto it = firedAt.find({i, due});
+        if (it != firedAt.end() && trueNow() - it->second < SIM_DUP_S) {
+            flag = "dup";
+            counts.duplicates++;
+        } else if (rtc > due + SIM_LATE_S && due != windowFrom - windowFrom % 60) {
+            flag = "late";
+            counts.late++;
+        } else {
+            counts.ok++;
+        }
+        firedAt[{i, due}] = trueNow();
+    }
+    traceLine(rtc, i, due, taskPortions(tasksGet(i)), (int32_t)(rtc - due), flag);
+    counts.steps += (uint64_t)taskPortions(tasksGet(i)) * PARTITION;
+    feedTask(i);
+}
+
+static void boot() {
+    setup();
+    board.rtc.intPin = intPin;
+    schedBegin(intPin, onFeed);
+    idleEnable(true);
+}
+
+// Питание отключается между операциями: очередь шины пуста, двигатель стоит
+static bool quiet() {
+    return busIdle() && !storeBusy() && !motionBusy() && !framerPending() && board.uart.nextArrival() == UINT64_MAX;
+}
+
+static void powerCycle() {
+    // Всё, что пришло по UART, уже разобрано
+    for (int k = ACT_EDIT; k <= ACT_STORM; k++) {
+        if (actions[k].queued) apply((ActionKind)k);
+    }
+    closeWindow((uint32_t)board.rtc.epoch(), true);
+    counts.outages++;
+    fakeAdvance(expUs(SIM_OUTAGE_S) + 60000000ULL);
+    if (rnd() % 10 == 0) {
+        // Села батарея часов: DS3231 начинает с 2000-01-01 и поднимает OSF
+        board.rtc.setEpoch(0);
+        board.rtc.stopOscillator();
+        counts.rtcLost++;
+        actions[ACT_SYNC].at = fakeNow() + expUs(SIM_RECONNECT_S);
+        actions[ACT_SYNC].queued = false;
+    }
+    boot();
+    openWindow((uint32_t)board.rtc.epoch(), true);
+    schedule(ACT_POWER, SIM_POWER_S);
+}
+
+int main(int argc, char **argv) {
+    double years = 10;
+    int positional = 0;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--int")) intPin = SIM_INT_PIN;
+        else if (!strcmp(argv[i], "--trace") && i + 1 < argc) trace = fopen(argv[++i], "w");
+        else if (positional++ == 0) years = atof(argv[i]);
+        else seed = strtoul(argv[i], nullptr, 0);
+    }
+    if (trace) fprintf(trace, "true time,rtc time,task,due,portions,offset s,flag\n");
+
+    uint32_t firstSeed = seed;
+    auto h0 = std::chrono::steady_clock::now();
+    fakeReset();
+    board.rtc.driftPpm = RTC_DRIFT_PPM;
+
+    // Первое включение: часы без времени, задачи по умолчанию
+    boot();
+    for (uint8_t i = 0; i < 3; i++) model[i] = tasksGet(i);
+    openWindow((uint32_t)board.rtc.epoch(), true);
+    actions[ACT_SYNC].at = fakeNow() + 300000000ULL;    // Приложение подключается через 5 минут
+    schedule(ACT_EDIT, 3600);
+    schedule(ACT_STORM, SIM_STORM_S);
+    schedule(ACT_POWER, SIM_POWER_S);
+
+    const uint64_t end = (uint64_t)(years * 365.25 * 86400.0 * 1e6);
+    uint64_t passes = 0;
+    while (fakeNow() < end) {
+        // Действия идут по одному: следующее — когда предыдущее обработано
+        int next = -1;
+        for (int k = ACT_EDIT; k <= ACT_STORM; k++) {
+            if (actions[k].queued) next = ACT_COUNT;
+            else if (next < 0 || (next < ACT_COUNT && actions[k].at < actions[next].at)) next = k;
+        }
+        if (next < ACT_COUNT && actions[next].at < fakeNow() + 3600000000ULL) queue((ActionKind)next);
+        if (fakeNow() >= actions[ACT_POWER].at && quiet()) powerCycle();
+
+        loop();
+        fakeAdvance(LOOP_PASS_US);
+        passes++;
+        applyDone();
+    }
+    while (motionBusy() || !busIdle()) { loop(); fakeAdvance(LOOP_PASS_US); }
+    closeWindow((uint32_t)board.rtc.epoch(), true);
+    double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - h0).count();
+
+    int mismatches = 0;
+    for (int i = 0; i < MAX_TASK; i++) if (tasksGet(i) != model[i]) mismatches++;
+    uint64_t stepsMade = board.pins[STEP].edges / 2;
+
+    printf("simulated %.2f years in %.2f s (x%.3g), seed %u, %s\n", fakeNow() / 1e6 / 86400 / 365.25, wall,
+           fakeNow() / 1e6 / wall, firstSeed, intPin >= 0 ? "DS3231 alarm on INT" : "millis deadline");
+    printf("loop passes %llu, timer interrupts %u, storm bytes %u, i2c transactions %u, eeprom page writes %u\n",
+           (unsigned long long)passes, board.timers[HAL_TIMER_MOTION].fires,
+           counts.stormBytes, board.bus.stats.transactions, board.eeprom.pageWrites);
+    printf("scenario: %u edits, %u time syncs, %u storms, %u outages (%u with RTC battery lost)\n",
+           counts.edits, counts.syncs, counts.storms, counts.outages, counts.rtcLost);
+    printf("uart: %u frames, %u crc errors, %u rx overflows; edits not applied %u\n", framerStats().frames,
+           framerStats().crcErrors, framerStats().overflows, counts.lostEdits);
+    printf("feedings: %u, on time %u, missed %u, duplicate %u, late %u, spurious %u, "
+           "on a wrong clock (>60 s off) %u\n", counts.feeds, counts.ok, counts.missed, counts.duplicates,
+           counts.late, counts.spurious, counts.wrongClock);
+    printf("steps: expected %llu, made %llu; schedule mismatches at end %d\n",
+           (unsigned long long)counts.steps, (unsigned long long)stepsMade, mismatches);
+    if (trace) fclose(trace);
+
+    bool failed = counts.lostEdits || counts.missed || counts.duplicates || counts.late || counts.spurious ||
+                  stepsMade != counts.steps || mismatches;
+    printf("%s\n", failed ? "FAIL" : "OK");
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,97 @@
+#include "idle.h"
+
+#include <string.h>
+
+#include "bus.h"
+#include "config.h"
+#include "framer.h"
+#include "hal.h"
+#include "history.h"
+#include "log.h"
+#include "main.h"
+#include "motion.h"
+#include "prof.h"
+#include "scheduler.h"
+#include "sync.h"
+
+#define IDLE_LOG_US ((uint32_t)LOG_DRAIN_BYTES * 10000000UL / 115200)  // Передача куска журнала
+#define IDLE_MAX_US 3600000000UL                                       // halMicros() не должен обогнать срок
+
+static bool enabled = true;
+static uint32_t wokeAt = 0;         // halMicros() последнего пробуждения
+static IdleStats stats;
+
+void idleBegin() {
+    memset(&stats, 0, sizeof(stats));
+    wokeAt = halMicros();
+}
+
+void idleEnable(bool on) {
+    enabled = on;
+    wokeAt = halMicros();
+}
+
+uint32_t idleBudgetUs() {
+    if (motionPending() || framerPending()) return 0;
+
+    // Очередь шины: ждать окончания цикла записи можно во сне, остальное — сразу
+    uint32_t budget = IDLE_MAX_US;
+    if (!busIdle()) {
+        if (!busWaiting()) return 0;
+        budget = IDLE_BUS_POLL_US;
+    } else if (LOG_LEVEL > LOG_LEVEL_NONE && logPending() > 0) {
+        budget = IDLE_LOG_US;
+    }
+
+    // Кадр ответа — как только он поместится в очередь передачи; история
+    // читает EEPROM, поэтому ещё ждёт свободной шины
+    if (syncStreaming() || taskListStreaming() || profStreaming() || (busIdle() && historyStreaming())) {
+        uint32_t us = framerRoomUs();
+        if (us == 0) return 0;
+        if (us < budget) budget = us;
+    }
+
+    uint32_t ms = schedIdleMs();
+
+    if (ms == 0) return 0;
+    if (ms < budget / 1000) budget = ms * 1000;
+    return budget;
+}
+
+// Пробуждение по прерыванию, которое требует прохода loop()
+static bool woken(IdleWake &cause) {
+    if (framerPending()) cause = IDLE_WAKE_UART;
+    else if (schedAlarmPending()) cause = IDLE_WAKE_RTC;
+    else if (motionPending()) cause = IDLE_WAKE_MOTION;
+    else return false;
+    return true;
+}
+
+void idleSleep() {
+    if (!enabled) return;
+
+    uint32_t start = halMicros();
+    stats.awakeUs += start - wokeAt;
+    uint32_t budget = idleBudgetUs();
+    if (budget == 0) {
+        stats.busyPasses++;
+        wokeAt = start;
+        return;
+    }
+
+    stats.sleeps++;
+    IdleWake cause = IDLE_WAKE_DEADLINE;
+    for (;;) {
+        uint32_t slept = halMicros() - start;
+        if (slept >= budget) break;
+        halSleepUs(budget - slept);
+        if (woken(cause)) break;
+    }
+    wokeAt = halMicros();
+    stats.asleepUs += wokeAt - start;
+    stats.wakes[cause]++;
+}
+
+const IdleStats &idleStats() {
+    return stats;
+}
@@ -0,0 +1,39 @@
+#ifndef idle_h
+#define idle_h
+
+// Сон ядра между событиями.
+// idleSleep() в конце loop() находит, сколько времени ничего не нужно делать:
+// до крайнего срока планировщика, до следующей проверки готовности EEPROM,
+// передачи куска журнала или места в очереди передачи для кадра истории.
+// На это время ядро засыпает (WFI) и просыпается раньше, если пришёл байт
+// по UART, будильник DS3231 опустил INT или двигатель закончил перемещение. Шаги двигателя формирует прерывание
+// таймера, оно будит ядро, но loop() при этом не запускается.
+// Если работа есть сразу, сна нет.
+
+#include <stdint.h>
+
+// Причина пробуждения
+enum IdleWake : uint8_t {
+    IDLE_WAKE_DEADLINE,     // Истёк срок сна
+    IDLE_WAKE_UART,         // Приняты байты
+    IDLE_WAKE_RTC,          // Будильник часов
+    IDLE_WAKE_MOTION,       // Перемещение завершено
+    IDLE_WAKE_COUNT
+};
+
+// Время в мкс по halMicros()
+struct IdleStats {
+    uint64_t awakeUs;       // Между пробуждением и следующим засыпанием
+    uint64_t asleepUs;
+    uint32_t sleeps;        // Засыпания
+    uint32_t busyPasses;    // Проходы loop() без сна: работа есть сразу
+    uint32_t wakes[IDLE_WAKE_COUNT];
+};
+
+void idleBegin();
+void idleEnable(bool on);           // Выключенный сон: loop() крутится без остановки
+void idleSleep();                   // Вызывать в конце loop()
+uint32_t idleBudgetUs();            // Сколько можно спать сейчас
+const IdleStats &idleStats();
+
+#endif
@@ -0,0 +1,74 @@
+#include "log.h"
+
+#include "Arduino.h"
+#include "hal.h"
+#include "ring.h"
+
+static_assert(sizeof(logLevels) == LOG_EVENT_COUNT && sizeof(logArgs) == LOG_EVENT_COUNT,
+              "Log event table is inconsistent");
+static_assert(LOG_EVENT_COUNT <= 256, "Log event must fit one byte");
+
+static Ring<LOG_BUFFER> ring;
+static uint32_t lastMs = 0;         // Время предыдущей записи
+static uint32_t lostPending = 0;    // Потерянные записи, о которых ещё не сообщено
+static LogStats stats;
+
+static uint8_t putVarint(uint8_t *p, uint32_t v) {
+    uint8_t n = 0;
+    while (v >= 0x80) {
+        p[n++] = (uint8_t)(v | 0x80);
+        v >>= 7;
+    }
+    p[n++] = (uint8_t)v;
+    return n;
+}
+
+// Запись целиком или ничего: декодер не должен увидеть половину записи
+static bool put(LogEvent event, uint32_t now, const uint32_t *args, uint8_t count) {
+    uint8_t rec[LOG_RECORD_MAX];
+    uint8_t n = 0;
+    rec[n++] = event;
+    n += putVarint(rec + n, now - lastMs);
+    for (uint8_t i = 0; i < count; i++) n += putVarint(rec + n, args[i]);
+
+    if (LOG_BUFFER - ring.size() < n) return false;
+    for (uint8_t i = 0; i < n; i++) ring.push(rec[i]);
+    lastMs = now;
+    stats.records++;
+    if (ring.size() > stats.maxUsed) stats.maxUsed = ring.size();
+    return true;
+}
+
+void logRecord(LogEvent event, const uint32_t *args, uint8_t count) {
+    uint32_t now = halMillis();
+    if (lostPending > 0) {
+        if (!put(LOG_LOST, now, &lostPending, 1)) {
+            lostPending++;
+            stats.lost++;
+            return;
+        }
+        lostPending = 0;
+    }
+    if (!put(event, now, args, count)) {
+        lostPending++;
+        stats.lost++;
+    }
+}
+
+// Кусок ограничен, чтобы проход loop() не ждал передачи всего буфера
+void logDrainChunk() {
+    uint8_t buf[LOG_DRAIN_BYTES];
+    uint8_t n = 0;
+    while (n < sizeof(buf) && ring.pop(buf[n])) n++;
+    if (n == 0) return;
+    Serial.write(buf, n);
+    stats.bytes += n;
+}
+
+uint16_t logPending() {
+    return ring.size();
+}
+
+const LogStats &logStats() {
+    return stats;
+}
@@ -0,0 +1,108 @@
+#ifndef log_h
+#define log_h
+
+// Отладочный журнал без Serial.print на пути обработки команд.
+// Сообщение — это номер события и числовые аргументы. Оно пишется двоичной
+// записью в кольцевой буфер в RAM, а logDrain() из loop() понемногу передаёт
+// буфер в Serial, когда шина I2C свободна. Текст сообщений нужен только
+// декодеру на хосте (host/logcat), в прошивку он не попадает.
+//
+// Уровень журнала задаётся при сборке (LOG_LEVEL в config.h). Сообщения выше
+// уровня отсекаются условием-константой: ни вызова, ни вычисления аргументов,
+// ни байта кода.
+//
+// Запись: событие (1) | миллисекунды от предыдущей записи | аргументы.
+// Миллисекунды и аргументы — числа uint32 в коде LEB128 (по 7 бит, старший
+// бит — продолжение), маленькие значения занимают один байт.
+// Запись, для которой нет места в буфере, теряется целиком; перед следующей
+// записью добавляется событие LOG_LOST с числом потерянных.
+//
+// Журнал пишется только из loop(), не из прерываний.
+
+#include <stdint.h>
+
+#include "config.h"
+
+#define LOG_LEVEL_NONE 0
+#define LOG_LEVEL_ERROR 1
+#define LOG_LEVEL_WARN 2
+#define LOG_LEVEL_INFO 3
+#define LOG_LEVEL_DEBUG 4
+
+// События: имя, уровень, число аргументов, текст для декодера.
+// В тексте %u, %d и %x — следующий аргумент, %% — знак процента.
+// Новые события добавляются в конец: номер события входит в запись
+#define LOG_EVENTS(X) \
+    X(LOG_LOST, LOG_LEVEL_ERROR, 1, "%u log records lost") \
+    X(LOG_START, LOG_LEVEL_INFO, 0, "Start") \
+    X(LOG_COMMAND, LOG_LEVEL_DEBUG, 2, "cmd: %x | len: %u") \
+    X(LOG_TASK_ADD, LOG_LEVEL_INFO, 5, "%u New task: %u:%u days: %x x%u") \
+    X(LOG_TASK_REMOVE, LOG_LEVEL_INFO, 3, "%u remove task: %u:%u") \
+    X(LOG_TASK_LIST, LOG_LEVEL_DEBUG, 6, "%u Task: %u:%u days: %x x%u exec: %u") \
+    X(LOG_TIME_SET, LOG_LEVEL_INFO, 6, "%u:%u:%u %u/%u/%u") \
+    X(LOG_SYNC_OUT, LOG_LEVEL_INFO, 1, "Sync out, version %u") \
+    X(LOG_SYNC_IN, LOG_LEVEL_INFO, 1, "Sync in, version %u") \
+    X(LOG_UNKNOWN_COMMAND, LOG_LEVEL_WARN, 1, "Unknown command: %x") \
+    X(LOG_PORTION_DONE, LOG_LEVEL_INFO, 1, "Portion done: %u") \
+    X(LOG_STORE_ERROR, LOG_LEVEL_ERROR, 1, "EEPROM write failed, %u errors") \
+    X(LOG_CLOCK_LOST, LOG_LEVEL_WARN, 0, "RTC oscillator stopped, time set to build time") \
+    X(LOG_READY, LOG_LEVEL_INFO, 3, "Ready in %u ms, schedule restored: %u, generation %u") \
+    X(LOG_BLE_BAUD, LOG_LEVEL_INFO, 2, "BLE UART %u baud, negotiation result %u") \
+    X(LOG_FEED_DROPPED, LOG_LEVEL_WARN, 2, "Feeding %u dropped: channel %u queue full or missing")
+
+enum LogEvent : uint8_t {
+#define LOG_ENUM(name, level, args, text) name,
+    LOG_EVENTS(LOG_ENUM)
+#undef LOG_ENUM
+    LOG_EVENT_COUNT
+};
+
+#define LOG_LEVEL_OF(name, level, args, text) level,
+#define LOG_ARGS_OF(name, level, args, text) args,
+constexpr uint8_t logLevels[] = {LOG_EVENTS(LOG_LEVEL_OF)};
+constexpr uint8_t logArgs[] = {LOG_EVENTS(LOG_ARGS_OF)};
+#undef LOG_LEVEL_OF
+#undef LOG_ARGS_OF
+
+constexpr bool logEnabled(LogEvent e) {
+    return logLevels[e] <= LOG_LEVEL;
+}
+
+#define LOG_MAX_ARGS 6
+#define LOG_RECORD_MAX (1 + 5 * (1 + LOG_MAX_ARGS))  // Событие, время и аргументы в худшем случае
+
+// Счётчики журнала
+struct LogStats {
+    uint32_t records;       // Записи, попавшие в буфер
+    uint32_t bytes;         // Байты, переданные в Serial
+    uint32_t lost;          // Записи, потерянные из-за заполненного буфера
+    uint16_t maxUsed;       // Наибольшее заполнение буфера, байт
+};
+
+void logRecord(LogEvent event, const uint32_t *args, uint8_t count);
+
+template <LogEvent E, typename... Args>
+inline void logWrite(Args... args) {
+    static_assert(sizeof...(Args) == logArgs[E], "Wrong number of log arguments");
+    static_assert(sizeof...(Args) <= LOG_MAX_ARGS, "Too many log arguments");
+    const uint32_t values[sizeof...(Args) + 1] = {(uint32_t)args...};
+    logRecord(E, values, sizeof...(Args));
+}
+
+// Сообщение журнала: LOG(LOG_TASK_ADD, idx, hour, minute, days, portions).
+// Выключенное уровнем сообщение не вычисляет аргументы
+#define LOG(event, ...) \
+    do { \
+        if (logEnabled(event)) logWrite<event>(__VA_ARGS__); \
+    } while (0)
+
+void logDrainChunk();               // Передать в Serial до LOG_DRAIN_BYTES байт
+uint16_t logPending();              // Байт в буфере
+const LogStats &logStats();
+
+// Вызывать из loop(), когда нет срочной работы
+inline void logDrain() {
+    if (LOG_LEVEL > LOG_LEVEL_NONE) logDrainChunk();
+}
+
+#endif
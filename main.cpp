@@ -1,313 +1,334 @@
-#include "config.h"         // Подключение пользовательского конфигурационного файла
+#include "main.h"           // Общие объявления скетча (задачи, пакеты, функции)
 
 #include "Arduino.h"        // Основная библиотека Arduino
-#include "buildTime.h"      // Файл с временем сборки (макросы BUILD_HOUR и т.д.)
-#include "time.h"           // Работа с временем
-
-// Структура для хранения задачи: время и факт выполнения
-struct Task {
-  Time t;                   // Время выполнения задачи
-  bool executed;            // Флаг, была ли задача выполнена
-};
-
-// Структура пакета, получаемого по Serial (например, BLE)
-struct Packet {
-    uint8_t command;                       // Команда
-    uint8_t payload[MAX_PAYLOAD_SIZE];    // Полезная нагрузка
-    uint8_t len;                           // Длина данных
+#include "ble.h"            // Скорость UART модуля BLE
+#include "bus.h"            // Очередь транзакций I2C
+#include "calendar.h"       // Даты и время сборки прошивки
+#include "framer.h"         // Разбор кадров, принятых по Serial1
+#include "hal.h"            // Доступ к I2C, UART, GPIO и часам
+#include "history.h"        // История кормлений в EEPROM
+#include "idle.h"           // Сон между событиями
+#include "log.h"            // Двоичный отладочный журнал
+#include "motion.h"         // Неблокирующее управление шаговыми двигателями
+#include "prof.h"           // Профилирование по счётчику тактов
+#include "scheduler.h"      // Ближайшее кормление по будильнику
+#include "sound.h"          // Сигналы пищалки по таймеру
+#include "store.h"          // Хранение задач в EEPROM
+#include "sync.h"           // Синхронизация расписания с приложением
+#include "tasks.h"          // Таблица задач и индекс срабатываний
+#include "uart.h"           // Передача по BLE без ожидания
+
+#include <string.h>
+
+// Задачи по умолчанию (8:00, 13:00, 20:00 каждый день по одной порции),
+// они используются, пока в EEPROM нет сохранённого расписания
+static const TaskEntry defaultTasks[] = {
+    taskMake(8, 0),
+    taskMake(13, 0),
+    taskMake(20, 0)
 };
 
-// Массив задач. Задано 3 задачи по умолчанию (8:00, 13:00, 20:00)
-Task tasks[MAX_TASK] = {
-    Task{Time{8, 0}, 0}, 
-    Task{Time{13, 0}, 0},
-    Task{Time{20, 0}, 0}
+// Задачи, выполненные с момента запуска, по биту на задачу
+static uint8_t executed[(MAX_TASK + 7) / 8];
+
+// Кормления в очередях двигателей: в историю они попадают, когда порции выданы.
+// Места хватает на все очереди, текущие перемещения и ещё не разобранные завершения
+#define FEED_PENDING ((MOTION_QUEUE + 1) * MOTION_CHANNELS + 4)
+struct PendingFeed {
+    bool used;
+    uint8_t id;             // Номер перемещения
+    uint8_t cause;          // HistoryCause
+    uint8_t task;           // Задача или канал для 0x04
+    uint8_t portions;
 };
+static PendingFeed pendingFeeds[FEED_PENDING];
+
+// Время последней команды приложения: команда после паузы BLE_SESSION_GAP_MS —
+// новое подключение
+static bool commandSeen = false;
+static uint32_t lastCommandMs = 0;
+
+// Ответ на TASK_LIST_COMMAND, кадр за проход loop()
+static bool listing = false;
+static uint16_t listNext = 0;       // Следующая задача для кадра
+static uint8_t listPart = 0;
+
+// Перемещение поставлено (id >= 0) или отклонено — отказ записывается сразу.
+// Сигнал кормления или ошибки звучит одновременно с двигателем
+static void feedQueued(int id, uint8_t cause, uint8_t task, uint8_t portions) {
+    soundPlay(id < 0 ? SOUND_ERROR : SOUND_FEEDING);
+    if (id < 0) {
+        historyAppend(clockEpoch(), HISTORY_DROPPED, task, portions);
+        return;
+    }
+    for (PendingFeed &f : pendingFeeds) {
+        if (f.used) continue;
+        f = PendingFeed{true, (uint8_t)id, cause, task, portions};
+        return;
+    }
+}
 
-unsigned long tmrOrder = 0;    // Таймер для проверки задач
-unsigned long tmrHandler = 0;  // Таймер для обработки пакетов
-Packet incomingPacket;         // Входящий пакет
-
-// Объявление функций
-bool isRmTask(uint8_t i);              
-void removeTask(uint8_t i);            
-void addTask(uint8_t i, Time t);       
-
-void readPacket();                     
-void handleCommand(const Packet& pkt); 
-
-void playSound();                     
-void go(unsigned int speed, uint16_t iter, bool dir); 
-
-void setupStepper();                  
-void setupSound();                    
-void setupTime();                     
-
-void writeTasksToEEPROM(uint16_t eepromAddr, Task *tasks, size_t count); 
-void readTasksFromEEPROM(uint16_t eepromAddr, Task *tasks, size_t count);
+static bool isExecuted(uint16_t i) {
+    return executed[i / 8] & (1 << (i % 8));
+}
 
 // Инициализация устройства
 void setup() {
-    Wire.begin();                          // Запуск I2C
+    uint32_t bootMs = halMillis();        // Время готовности к кормлению — в журнал
+    profBegin();                          // Счётчик тактов и таблица замеров
+    halI2cBegin();                         // Запуск I2C
     Serial.begin(115200);                 // Отладочный порт
-    Serial1.begin(9600);                  // Вторичный порт, например BLE
+    BleResult ble = bleBegin();           // Порт BLE: скорость согласуется с модулем HM-10
+    framerBegin();                        // Приём кадров по прерыванию
 
-    setupStepper();                       // Инициализация шагового двигателя
-    setupSound();                         // Инициализация звука
-    setupTime();                          // Установка времени
+    motionBegin();                        // Инициализация шагового двигателя
+    motionOnDone(onPortionDone);          // Сообщение о выданной порции
+    soundBegin();                         // Пищалка: сигналы играет таймер
 
-    Serial.println("Start");
+    LOG(LOG_START);
+    LOG(LOG_BLE_BAUD, bleBaud(), ble);
+    clockBegin();                         // Программные часы сверятся с DS3231
+    setupTime();                          // Установка времени, если оно потеряно
 
-    memset(tasks, 0, sizeof(tasks));      // Обнуление задач
+    historyBegin();                       // Текущая страница истории кормлений, до записей хранилища
 
-    readTasksFromEEPROM(EEPROM_START_ADDR, tasks, MAX_TASK);  // Загрузка задач из EEPROM
+    // Загрузка задач из EEPROM: образ с проверкой CRC, при ошибке — задачи по умолчанию
+    bool restored = storeBegin(defaultTasks, sizeof(defaultTasks) / sizeof(defaultTasks[0]));
+    tasksBegin();
+    memset(executed, 0, sizeof(executed));
+    memset(pendingFeeds, 0, sizeof(pendingFeeds));
+    commandSeen = false;
+
+    schedBegin(RTC_INT, feedTask);        // Планировщик кормлений
+    idleBegin();                          // Счётчики сна
+
+    LOG(LOG_READY, halMillis() - bootMs, restored, storeStats().generation);
 }
   
 // Главный цикл программы
 void loop() {
-    // Проверка задач каждую секунду
-    if (millis() - tmrOrder > 1000){
-        tmrOrder = millis();
-    
-        Time now = getTime();             // Текущее время
-        for (int i = 0; i < MAX_TASK; i++){
-            if (isRmTask(i)) continue;    // Пропустить "удалённые" задачи
-            
-            // Выполнить задачу, если время совпадает
-            if (!tasks[i].executed && equalTime(now, tasks[i].t)) {
-                playSound();
-                go(SPEED, PARTITION, 1);
-                tasks[i].executed = true;
-            }
+    PROF_SCOPE(PROF_LOOP);
 
-            // Сброс флага, если текущее время отличается
-            if (!equalTime(now, tasks[i].t)){
-                tasks[i].executed = false;
-            }
-        }
-    }
+    readPacket();                         // Разбор всех принятых кадров: кормление — уже по новому расписанию
 
-    // Обработка входящих пакетов каждую секунду
-    if (millis() - tmrHandler > 1000){
-        tmrHandler = millis();
-        readPacket();
-    }
-} 
+    schedPoll();                          // Кормление, если наступило его время
 
-// Чтение команды по Serial1
-void readPacket() {
-    if (Serial1.available() > 0) {
-        incomingPacket.command = Serial1.read();   // Чтение команды
-        incomingPacket.len = Serial1.read();       // Чтение длины данных
+    motionPoll();                         // Сообщения о завершённых перемещениях
 
-        Serial.print("cmd: ");
-        Serial.print(incomingPacket.command, HEX);
-        Serial.print(" | len: ");
-        Serial.println(incomingPacket.len);
+    historyPoll();                        // Кадр выгрузки истории, если есть место для передачи
 
-        if (incomingPacket.len > MAX_PAYLOAD_SIZE) {
-            incomingPacket.len = MAX_PAYLOAD_SIZE;
-        }
+    syncPoll();                           // Кадры ответов 0x85, 0x89, 0x87 — так же по одному
+    taskListPoll();
+    profPoll();
 
-        size_t bytesRead = Serial1.readBytes(incomingPacket.payload, incomingPacket.len);  // Чтение данных
-        Serial.print("Bytes read: ");
-        Serial.println(bytesRead);
+    busPoll();                            // Один шаг обмена с RTC и EEPROM
 
-        // Вывод считанных байт
-        for (int i = 0; i < MAX_PAYLOAD_SIZE; i++){
-            Serial.print(incomingPacket.payload[i], HEX);
-            Serial.print(' ');
-        }
-        Serial.println();
+    storePoll();                          // Страница хранилища, не поместившаяся в очередь шины
 
-        // Обработка команды, если данные получены полностью
-        if (bytesRead == incomingPacket.len) {
-            handleCommand(incomingPacket);
-        } else {
-            Serial.println("Timeout while receiving payload");
-        }
+    if (busIdle()) {                      // Отладочный журнал — в свободное время
+        PROF_SCOPE(PROF_LOG_DRAIN);
+        logDrain();
     }
+
+    idleSleep();                          // Сон до следующего события
+} 
+
+// Разбор кадров, накопленных в буфере приёма Serial1, без ожидания
+void readPacket() {
+    PROF_SCOPE(PROF_READ_PACKET);
+    framerPoll(handleCommand);
 }
 
 // Обработка команды
 void handleCommand(const Packet& pkt) {
+    PROF_SCOPE(PROF_HANDLE_COMMAND);
+    LOG(LOG_COMMAND, pkt.command, pkt.len);
+
+    uint32_t now = halMillis();
+    if (!commandSeen || now - lastCommandMs >= BLE_SESSION_GAP_MS) soundPlay(SOUND_CONNECTED);
+    commandSeen = true;
+    lastCommandMs = now;
+
     switch (pkt.command) {
-        case 0x00: // Добавить задачу
+        case 0x00: // Добавить задачу: часы, минуты, номер [, дни недели, порции, канал двигателя]
             if (pkt.len >= 3) {
                 uint8_t hour = pkt.payload[0];
                 uint8_t minute = pkt.payload[1];
                 uint8_t idx = pkt.payload[2];
+                uint8_t days = pkt.len >= 4 ? pkt.payload[3] : TASK_EVERY_DAY;
+                uint8_t portions = pkt.len >= 5 ? pkt.payload[4] : 1;
+                uint8_t channel = pkt.len >= 6 ? pkt.payload[5] : 0;
 
-                Serial.print(idx);
-                Serial.print(" New task: ");
-                Serial.print(hour);
-                Serial.print(":");
-                Serial.println(minute);
-
-                addTask(idx, Time{hour, minute});
+                LOG(LOG_TASK_ADD, idx, hour, minute, days, portions);
+                addTask(idx, Time{hour, minute}, days, portions, channel);
             }
             break;
 
         case 0x01: // Удалить задачу
             if (pkt.len >= 1) {
                 uint8_t idx = pkt.payload[0];
-                Serial.print(idx);
-                Serial.print(" remove task: ");
-                Serial.print(tasks[idx].t.hours);
-                Serial.print(":");
-                Serial.println(tasks[idx].t.minutes);
-
+                LOG(LOG_TASK_REMOVE, idx, taskHours(tasksGet(idx)), taskMinutes(tasksGet(idx)));
                 removeTask(idx);
             }
             break;
 
-        case 0x02: // Отправить список задач
-            for (int i = 0; i < MAX_TASK; i++){
-                Serial.print(i);
-                Serial.print(" Task: ");
-                Serial.print(tasks[i].t.hours);
-                Serial.print(':');
-                Serial.print(tasks[i].t.minutes);
-                Serial.print(" exec: ");
-                Serial.println(tasks[i].executed); 
+        case 0x02: // Отправить список задач приложению Cat.aia: часы и минуты
+                   // первых TASK_LIST_LEGACY задач, свободная — TASK_LIST_FREE часов
+            for (uint16_t i = 0; i < TASK_LIST_LEGACY; i++) {
+                TaskEntry e = tasksGet(i);
+                uint8_t rec[2] = {TASK_LIST_FREE, 0};
+                if (taskUsed(e)) {
+                    LOG(LOG_TASK_LIST, i, taskHours(e), taskMinutes(e), taskDays(e), taskPortions(e), isExecuted(i));
+                    rec[0] = taskHours(e);
+                    rec[1] = taskMinutes(e);
+                }
 
                 // Отправка по BLE
-                Serial1.write(tasks[i].t.hours);
-                Serial1.write(tasks[i].t.minutes);
-            }   
+                uartWriteAll(rec, sizeof(rec));
+            }
             break;
 
         case 0x03: // Установка времени
             if (pkt.len >= 6) {
                 setTime(pkt.payload[0], pkt.payload[1], pkt.payload[2], 
                         pkt.payload[3], pkt.payload[4], pkt.payload[5]+2000);
-                
-                // Отладочный вывод
-                Serial.print(pkt.payload[2]); Serial.print(':');
-                Serial.print(pkt.payload[1]); Serial.print(':');
-                Serial.print(pkt.payload[0]); Serial.print(' ');
-                Serial.print(pkt.payload[3]); Serial.print('/');
-                Serial.print(pkt.payload[4]); Serial.print('/');
-                Serial.println(pkt.payload[5]+2000);
+                schedTimeChanged();
+                LOG(LOG_TIME_SET, pkt.payload[2], pkt.payload[1], pkt.payload[0],
+                    pkt.payload[3], pkt.payload[4], pkt.payload[5] + 2000);
             }
             break;
 
-        case 0x04: // Принудительный запуск двигателя и звука
-            playSound();
-            go(SPEED, PARTITION, 1);
+        case 0x04: { // Принудительный запуск двигателя и звука [, канал]
+            uint8_t channel = pkt.len >= 1 ? pkt.payload[0] : 0;
+            int id = motionEnqueue(motionChannel(channel).speed, motionChannel(channel).partition, 1, channel);
+            feedQueued(id, HISTORY_MANUAL, channel, 1);
             break;
+        }
 
-        default:
-            Serial.print("Unknown command: ");
-            Serial.println(pkt.command, HEX);
+        case SYNC_DOWNLOAD: // Выгрузка расписания в приложение
+            syncDownload(pkt);
+            LOG(LOG_SYNC_OUT, tasksVersion());
             break;
-    }
-}
 
-// Добавление задачи
-void addTask(uint8_t i, Time t){
-    if (i >= MAX_TASK) return;
+        case SYNC_UPLOAD: // Часть расписания из приложения
+            syncUpload(pkt);
+            if (pkt.len >= 3 && (pkt.payload[2] & SYNC_LAST)) {
+                LOG(LOG_SYNC_IN, tasksVersion());
+            }
+            break;
 
-    tasks[i] = Task{t, 0};
-    writeTasksToEEPROM(EEPROM_START_ADDR, tasks, MAX_TASK);  // Сохранение в EEPROM
-}
+        case TASK_LIST_COMMAND: // Полный список задач кадрами 0x89
+            sendTaskList();
+            break;
 
-// Удаление задачи
-void removeTask(uint8_t i){
-    if (i >= MAX_TASK) return;
+        case HISTORY_COMMAND: // Выгрузка истории кормлений [с номера страницы]
+            historyRequest(pkt);
+            break;
 
-    tasks[i] = Task{Time{100, 0}, 0};  // Некорректное время — считается удалённой
-    writeTasksToEEPROM(EEPROM_START_ADDR, tasks, MAX_TASK);
-}
+        case PROF_COMMAND: // Таблица профилирования [| PROF_RESET]
+            profSend(pkt.len >= 1 ? pkt.payload[0] : 0);
+            break;
 
-// Проверка, является ли задача удалённой
-bool isRmTask(uint8_t i){
-    if (i >= MAX_TASK) return true;
-    return tasks[i].t.hours > 23 || tasks[i].t.minutes > 59;
+        default:
+            LOG(LOG_UNKNOWN_COMMAND, pkt.command);
+            break;
+    }
 }
 
-// Воспроизведение звука
-void playSound(){
-    digitalWrite(SOUND, 0);
-    digitalWrite(SOUND, 1);
+// Ответ на TASK_LIST_COMMAND: занятые задачи по TASK_LIST_PER_FRAME в кадре
+void sendTaskList() {
+    listing = true;
+    listNext = 0;
+    listPart = 0;
 }
 
-// Движение шагового двигателя
-void go(unsigned int speed, uint16_t iter, bool dir){
-    digitalWrite(EN, 0);            // Включить драйвер
-    digitalWrite(DIR, dir);         // Установить направление
-
-    for (uint16_t i = 0; i < iter; i++){
-        digitalWrite(STEP, 1);
-        delayMicroseconds(speed);
-        digitalWrite(STEP, 0);
-        delayMicroseconds(speed);
+// Кадр списка, когда он помещается в очередь передачи
+void taskListPoll() {
+    static_assert(TASK_LIST_PER_FRAME * (TASK_LIST_PART + 1) >= MAX_TASK, "Task list does not fit the part numbers");
+    if (!listing || framerRoomUs() != 0) return;
+
+    uint8_t frame[TASK_LIST_HEADER + TASK_LIST_PER_FRAME * TASK_LIST_RECORD];
+    uint8_t records = 0;
+    for (; listNext < MAX_TASK && records < TASK_LIST_PER_FRAME; listNext++) {
+        TaskEntry e = tasksGet(listNext);
+        if (!taskUsed(e)) continue;
+
+        LOG(LOG_TASK_LIST, listNext, taskHours(e), taskMinutes(e), taskDays(e), taskPortions(e), isExecuted(listNext));
+        uint8_t *rec = frame + TASK_LIST_HEADER + records * TASK_LIST_RECORD;
+        rec[0] = (uint8_t)listNext;
+        rec[1] = taskHours(e);
+        rec[2] = taskMinutes(e);
+        rec[3] = taskDays(e);
+        rec[4] = taskPortions(e);
+        records++;
     }
+    // Последний кадр — тот, после которого занятых задач не осталось
+    while (listNext < MAX_TASK && !taskUsed(tasksGet(listNext))) listNext++;
+    bool last = listNext == MAX_TASK;
 
-    digitalWrite(EN, 1);            // Отключить драйвер
-}
-// Настройка шагового двигателя
-void setupStepper(){
-    pinMode(DIR, OUTPUT);    // Установка пина направления как выход
-    pinMode(EN, OUTPUT);     // Установка пина включения как выход
-    pinMode(STEP, OUTPUT);   // Установка пина шага как выход
-
-    digitalWrite(EN, 1);     // Отключение драйвера по умолчанию (EN = HIGH)
-    digitalWrite(DIR, 1);    // Установка направления по умолчанию
+    frame[0] = (last ? TASK_LIST_LAST : 0) | listPart++;
+    framerSend(TASK_LIST_REPLY, frame, TASK_LIST_HEADER + records * TASK_LIST_RECORD);
+    if (last) listing = false;
 }
 
-// Настройка пина для звука (пищалки)
-void setupSound(){
-    pinMode(SOUND, OUTPUT);  // Установка пина звука как выход
-    digitalWrite(SOUND, 1);  // Установка высокого уровня (пищалка выключена)
+bool taskListStreaming() {
+    return listing;
 }
 
-// Установка времени при старте — используется время сборки прошивки
-void setupTime(){
-    setTime(BUILD_SEC, BUILD_MIN, BUILD_HOUR, BUILD_DAY, BUILD_MONTH, BUILD_YEAR);
-}
+// Добавление задачи. Неверное время или пустые дни недели освобождают запись,
+// канал без двигателя отклоняет команду, как запись загрузки 0x06
+void addTask(uint16_t i, Time t, uint8_t days, uint8_t portions, uint8_t channel){
+    if (i >= MAX_TASK || channel >= MOTION_CHANNELS) return;
+    TaskEntry e = taskMake(t.hours, t.minutes, days, portions, channel);
+    if (!taskValid(e)) return;
 
-// Запись массива задач в EEPROM по I2C
-void writeTasksToEEPROM(uint16_t eepromAddr, Task *tasks, size_t count) {
-    uint8_t *ptr = (uint8_t *)tasks;                   // Указатель на данные как на массив байт
-    size_t totalBytes = count * sizeof(Task);          // Общее количество байт для записи
+    tasksSet(i, e);                       // Запись изменения в журнал EEPROM
+    executed[i / 8] &= ~(1 << (i % 8));
+    schedInvalidate();
+}
 
-    while (totalBytes > 0) {
-        Wire.beginTransmission(EEPROM_ADDR);           // Начало передачи
-        Wire.write((uint8_t)(eepromAddr >> 8));        // Старший байт адреса
-        Wire.write((uint8_t)(eepromAddr & 0xFF));      // Младший байт адреса
+// Удаление задачи
+void removeTask(uint16_t i){
+    if (i >= MAX_TASK) return;
 
-        uint8_t pageLeft = 32 - (eepromAddr % 32);     // Вычисление оставшегося места на странице
-        uint8_t toWrite = min(pageLeft, totalBytes);   // Определение, сколько байт можно записать
+    tasksSet(i, TASK_FREE);
+    executed[i / 8] &= ~(1 << (i % 8));
+    schedInvalidate();
+}
 
-        Wire.write(ptr, toWrite);                      // Запись данных
-        Wire.endTransmission();                        // Завершение передачи
-        delay(5);                                      // Задержка для завершения записи
+// Кормление по задаче i: порции выдаются одним перемещением на канале задачи
+void feedTask(uint8_t i){
+    TaskEntry e = tasksGet(i);
+    uint8_t channel = taskChannel(e);
+    const MotionChannel &m = motionChannel(channel);
+    int id = motionEnqueue(m.speed, m.partition * taskPortions(e), 1, channel);
+    if (id < 0) LOG(LOG_FEED_DROPPED, i, channel);
+    feedQueued(id, HISTORY_SCHEDULED, i, taskPortions(e));
+    executed[i / 8] |= 1 << (i % 8);
+}
 
-        eepromAddr += toWrite;                         // Смещение адреса
-        ptr += toWrite;                                // Смещение указателя
-        totalBytes -= toWrite;                         // Уменьшение количества оставшихся байт
+// Порция выдана: двигатель остановился, кормление — в историю
+void onPortionDone(uint8_t id){
+    LOG(LOG_PORTION_DONE, id);
+    for (PendingFeed &f : pendingFeeds) {
+        if (!f.used || f.id != id) continue;
+        historyAppend(clockEpoch(), f.cause, f.task, f.portions);
+        f.used = false;
+        return;
     }
 }
 
-// Чтение массива задач из EEPROM по I2C
-void readTasksFromEEPROM(uint16_t eepromAddr, Task *tasks, size_t count) {
-    uint8_t *ptr = (uint8_t *)tasks;                   // Указатель на буфер
-    size_t totalBytes = count * sizeof(Task);          // Общее количество байт для чтения
-
-    while (totalBytes > 0) {
-        Wire.beginTransmission(EEPROM_ADDR);           // Начало передачи
-        Wire.write((uint8_t)(eepromAddr >> 8));        // Старший байт адреса
-        Wire.write((uint8_t)(eepromAddr & 0xFF));      // Младший байт адреса
-        Wire.endTransmission(false);                   // Повторный старт (не завершаем)
-
-        uint8_t toRead = min(32, totalBytes);          // Не больше 32 байт за раз
-        Wire.requestFrom(EEPROM_ADDR, toRead);         // Запрос на чтение
-        for (uint8_t i = 0; i < toRead && Wire.available(); i++) {
-            *ptr++ = Wire.read();                      // Чтение байта
-        }
+// Время сборки прошивки, секунды от 2000-01-01, вычисляется при компиляции
+static constexpr uint32_t buildEpoch = calendarBuildEpoch(__DATE__, __TIME__);
+static_assert(buildEpoch > epochFromCivil(2024, 1, 1, 0, 0, 0), "Build time must be parsed at compile time");
 
-        eepromAddr += toRead;                          // Смещение адреса
-        totalBytes -= toRead;                          // Уменьшение количества оставшихся байт
-    }
+// Установка времени при старте. Время сборки прошивки записывается, только
+// если часы останавливались (OSF): после обычного перезапуска DS3231 идёт
+// от батареи и его время верное
+void setupTime(){
+    if (!clockLost()) return;
+    DateTime b = fromEpoch(buildEpoch);
+    setTime(b.seconds, b.minutes, b.hours, b.date, b.month, b.year);
+    soundPlay(SOUND_ERROR);
+    LOG(LOG_CLOCK_LOST);
 }
@@ -0,0 +1,51 @@
+#ifndef main_h
+#define main_h
+
+// Общие объявления скетча: используются прошивкой и нативной сборкой (host/)
+
+#include <stddef.h>
+
+#include "config.h"
+#include "tasks.h"
+#include "time.h"
+
+// 0x02 — список задач в формате приложения Cat.aia, без обрамления:
+//   часы и минуты первых TASK_LIST_LEGACY задач, свободная — часы TASK_LIST_FREE.
+// 0x09 — полный список: кадры 0x89 «флаги (1) | записи по 5 байт: номер,
+//   часы, минуты, дни, порции» по занятым задачам. Флаги: биты 0..5 — номер
+//   кадра, TASK_LIST_LAST — последний кадр. Кадры уходят по одному за проход loop().
+#define TASK_LIST_LEGACY 6          // Столько задач показывает Cat.aia
+#define TASK_LIST_FREE 100          // Часы свободной задачи в ответе 0x02
+#define TASK_LIST_COMMAND 0x09
+#define TASK_LIST_REPLY 0x89
+#define TASK_LIST_HEADER 1
+#define TASK_LIST_RECORD 5
+#define TASK_LIST_PER_FRAME ((MAX_PAYLOAD_SIZE - TASK_LIST_HEADER) / TASK_LIST_RECORD)
+#define TASK_LIST_PART 0x3F
+#define TASK_LIST_LAST 0x80
+
+// Структура пакета, получаемого по Serial (например, BLE)
+struct Packet {
+    uint8_t command;                       // Команда
+    uint8_t payload[MAX_PAYLOAD_SIZE];    // Полезная нагрузка
+    uint8_t len;                           // Длина данных
+};
+
+void setup();
+void loop();
+
+void removeTask(uint16_t i);
+void addTask(uint16_t i, Time t, uint8_t days = TASK_EVERY_DAY, uint8_t portions = 1, uint8_t channel = 0);
+
+void readPacket();
+void handleCommand(const Packet& pkt);
+void sendTaskList();
+void taskListPoll();                // Вызывать из loop(): очередной кадр ответа 0x89
+bool taskListStreaming();
+
+void feedTask(uint8_t i);
+void onPortionDone(uint8_t id);
+
+void setupTime();
+
+#endif
@@ -0,0 +1,220 @@
+#include "motion.h"
+
+#include "hal.h"
+#include "ramp.h"
+
+#define MOTION_TOP_HZ (500000UL / SPEED)
+
+static constexpr RampTable<MOTION_PROFILE, MOTION_START_HZ, MOTION_TOP_HZ, MOTION_ACCEL> accelRamp{};
+static constexpr RampTable<MOTION_PROFILE, MOTION_START_HZ, MOTION_TOP_HZ, MOTION_DECEL> decelRamp{};
+
+static constexpr MotionChannel config[] = MOTION_CHANNEL_TABLE;
+static_assert(MOTION_CHANNELS >= 1 && MOTION_CHANNELS <= sizeof(config) / sizeof(config[0]),
+              "MOTION_CHANNEL_TABLE must describe every channel");
+static_assert(MOTION_CHANNELS <= 8, "Task entries keep the channel in 3 bits");
+static_assert(MOTION_MERGE_US < SPEED, "Merged edges must not skip a half-period");
+
+// Перемещение из очереди
+struct Move {
+    uint16_t speed;     // Полупериод импульса STEP, мкс
+    uint16_t iter;      // Количество шагов
+    bool dir;           // Направление
+    uint8_t id;         // Номер для сообщения о завершении
+};
+
+// Состояние канала. Очередь пишет loop(), читает прерывание, а пока таймер
+// стоит — kick(). Индексы свободно бегут по uint8_t, поэтому MOTION_QUEUE — степень двойки
+struct Channel {
+    Move queue[MOTION_QUEUE];
+    volatile uint8_t qHead;
+    volatile uint8_t qTail;
+    volatile bool active;   // Выполняет перемещение
+    Move current;
+    uint32_t halfSteps;     // Оставшиеся полупериоды текущего перемещения
+    uint16_t stepIndex;     // Номер текущего шага перемещения
+    bool stepLevel;         // Уровень на выводе STEP
+    int32_t wait;           // До следующего фронта от прошлого прерывания, мкс
+};
+
+static Channel channels[MOTION_CHANNELS];
+static uint8_t nextId = 0;
+
+// Завершённые перемещения всех каналов: пишет прерывание, читает motionPoll()
+#define MOTION_DONE 8
+static volatile uint8_t doneIds[MOTION_DONE];
+static volatile uint8_t doneHead = 0;
+static uint8_t doneTail = 0;
+
+static volatile bool running = false;   // Таймер генератора запущен
+static int32_t period = 0;               // Текущий период таймера, мкс
+static MotionStats stats;
+static MotionCallback onDone = nullptr;
+
+// Разгон по номеру шага, торможение по числу оставшихся шагов: берётся
+// меньшая из двух скоростей, но не больше заданной speed
+uint16_t motionHalfPeriod(uint16_t speed, uint16_t iter, uint16_t k) {
+    uint16_t half = speed;
+    if (k < accelRamp.size && accelRamp.half[k] > half) half = accelRamp.half[k];
+    uint16_t left = iter - 1 - k;
+    if (left < decelRamp.size && decelRamp.half[left] > half) half = decelRamp.half[left];
+    return half;
+}
+
+// Загрузка следующего перемещения канала; false — очередь пуста.
+// Первый фронт — через полупериод шага 0 после текущего момента счётчика
+static bool loadNext(uint8_t c) {
+    Channel &ch = channels[c];
+    if (ch.qHead == ch.qTail) return false;
+    ch.current = ch.queue[ch.qTail % MOTION_QUEUE];
+    ch.qTail++;
+
+    ch.halfSteps = (uint32_t)ch.current.iter * 2;
+    ch.stepIndex = 0;
+    ch.wait += motionHalfPeriod(ch.current.speed, ch.current.iter, 0);
+    ch.active = true;
+    halPinWrite(config[c].en, 0);               // Включить драйвер
+    halPinWrite(config[c].dir, ch.current.dir); // Установить направление
+    return true;
+}
+
+// Очередной фронт STEP канала: следующий фронт — через полупериод по таблице
+static void edge(uint8_t c) {
+    Channel &ch = channels[c];
+    if (ch.halfSteps > 0) {
+        ch.halfSteps--;
+        ch.stepLevel = !ch.stepLevel;
+        halPinWrite(config[c].step, ch.stepLevel);
+        stats.edges++;
+        if (ch.halfSteps > 0) {
+            // Шаг закончился спадом: следующий шаг по таблице
+            if (!ch.stepLevel) ch.stepIndex++;
+            ch.wait += motionHalfPeriod(ch.current.speed, ch.current.iter, ch.stepIndex);
+            return;
+        }
+    }
+
+    // Перемещение закончено
+    doneIds[doneHead % MOTION_DONE] = ch.current.id;
+    doneHead++;
+    if (loadNext(c)) return;
+
+    halPinWrite(config[c].en, 1);   // Отключить драйвер
+    ch.active = false;
+    ch.wait = 0;
+}
+
+// Прерывание таймера: с прошлого вызова прошло period мкс. Выдаются фронты
+// каналов, до которых меньше MOTION_MERGE_US, простаивающие каналы берут
+// перемещения из очереди, таймер взводится до ближайшего фронта
+static void stepIsr() {
+    stats.interrupts++;
+    int32_t next = INT32_MAX;
+    bool served = false;
+    for (uint8_t c = 0; c < MOTION_CHANNELS; c++) {
+        Channel &ch = channels[c];
+        if (ch.active) {
+            ch.wait -= period;
+            if (ch.wait < MOTION_MERGE_US) {
+                if (served) stats.merged++;
+                served = true;
+                edge(c);
+            }
+        } else {
+            loadNext(c);
+        }
+        if (ch.active && ch.wait < next) next = ch.wait;
+    }
+
+    if (next == INT32_MAX) {
+        halTimerStop(HAL_TIMER_MOTION);
+        running = false;
+        return;
+    }
+    period = next;
+    halTimerSetPeriod(HAL_TIMER_MOTION, period);
+}
+
+// Запуск таймера, если он стоит, а в очередях есть перемещения.
+// Пока таймер остановлен, прерывание не обращается к очередям, поэтому гонки нет
+static void kick() {
+    if (running) return;
+    int32_t next = INT32_MAX;
+    for (uint8_t c = 0; c < MOTION_CHANNELS; c++) {
+        if (loadNext(c) && channels[c].wait < next) next = channels[c].wait;
+    }
+    if (next == INT32_MAX) return;
+    running = true;
+    period = next;
+    halTimerStart(HAL_TIMER_MOTION, period, stepIsr);
+}
+
+void motionBegin() {
+    if (running) halTimerStop(HAL_TIMER_MOTION);
+    running = false;
+    period = 0;
+    doneHead = doneTail = 0;
+
+    for (uint8_t c = 0; c < MOTION_CHANNELS; c++) {
+        channels[c] = Channel();
+        halPinOutput(config[c].dir);    // Установка пина направления как выход
+        halPinOutput(config[c].en);     // Установка пина включения как выход
+        halPinOutput(config[c].step);   // Установка пина шага как выход
+
+        halPinWrite(config[c].en, 1);   // Отключение драйвера по умолчанию (EN = HIGH)
+        halPinWrite(config[c].dir, 1);  // Установка направления по умолчанию
+        halPinWrite(config[c].step, 0);
+    }
+}
+
+int motionEnqueue(unsigned int speed, uint16_t iter, bool dir, uint8_t channel) {
+    if (channel >= MOTION_CHANNELS) return -1;
+    Channel &ch = channels[channel];
+    if ((uint8_t)(ch.qHead - ch.qTail) >= MOTION_QUEUE) return -1;
+
+    uint8_t id = nextId++;
+    ch.queue[ch.qHead % MOTION_QUEUE] = Move{(uint16_t)speed, iter, dir, id};
+    ch.qHead++;
+
+    kick();
+    return id;
+}
+
+bool motionChannelBusy(uint8_t channel) {
+    const Channel &ch = channels[channel];
+    return ch.active || ch.qHead != ch.qTail;
+}
+
+bool motionBusy() {
+    if (running) return true;
+    for (uint8_t c = 0; c < MOTION_CHANNELS; c++) {
+        if (motionChannelBusy(c)) return true;
+    }
+    return false;
+}
+
+const MotionChannel &motionChannel(uint8_t channel) {
+    return config[channel < MOTION_CHANNELS ? channel : 0];
+}
+
+void motionOnDone(MotionCallback cb) {
+    onDone = cb;
+}
+
+bool motionPending() {
+    return doneTail != doneHead;
+}
+
+void motionPoll() {
+    // Прерывание могло остановиться, не увидев только что добавленное перемещение
+    kick();
+
+    while (doneTail != doneHead) {
+        uint8_t id = doneIds[doneTail % MOTION_DONE];
+        doneTail++;
+        if (onDone) onDone(id);
+    }
+}
+
+const MotionStats &motionStats() {
+    return stats;
+}
@@ -0,0 +1,54 @@
+#ifndef motion_h
+#define motion_h
+
+// Неблокирующий генератор шагов для MOTION_CHANNELS шаговых двигателей.
+// Перемещения ставятся в очередь своего канала, импульсы STEP всех каналов
+// формирует одно прерывание аппаратного таймера, а loop() лишь забирает
+// сообщения о завершении.
+// Каждое перемещение начинается разгоном с MOTION_START_HZ и заканчивается
+// торможением до неё же по таблицам ramp.h; полупериод шага не меньше speed.
+// Каналы чередуются по Брезенхему: у каждого свой счётчик времени до
+// следующего фронта, таймер взводится на ближайший из них, и фронты других
+// каналов, до которых меньше MOTION_MERGE_US, выдаются в том же прерывании.
+// Досрочность фронта остаётся в счётчике и сокращает следующий полупериод,
+// поэтому средняя скорость каждого канала точная. С одним каналом фронты
+// идут точно по таблице.
+
+#include <stdint.h>
+
+#include "config.h"
+
+#define MOTION_QUEUE 4      // Максимальное количество перемещений в очереди канала
+
+// Канал: выводы драйвера и параметры кормления по умолчанию
+struct MotionChannel {
+    uint8_t en, dir, step;
+    uint16_t speed;         // Полупериод на полной скорости, мкс, не меньше SPEED
+    uint16_t partition;     // Шагов на порцию
+};
+
+// Счётчики прерывания генератора
+struct MotionStats {
+    uint32_t interrupts;    // Вызовы прерывания
+    uint32_t edges;         // Выданные фронты STEP всех каналов
+    uint32_t merged;        // Из них выданные досрочно вместе с фронтом другого канала
+};
+
+typedef void (*MotionCallback)(uint8_t id);  // id — номер перемещения из motionEnqueue
+
+void motionBegin();
+
+// Поставить перемещение в очередь канала: iter шагов, полупериод speed мкс на полной скорости.
+// Возвращает номер перемещения или -1, если очередь заполнена или канала нет
+int motionEnqueue(unsigned int speed, uint16_t iter, bool dir, uint8_t channel = 0);
+
+bool motionBusy();                          // Какой-либо двигатель вращается или очередь не пуста
+bool motionChannelBusy(uint8_t channel);
+const MotionChannel &motionChannel(uint8_t channel);
+void motionOnDone(MotionCallback cb);       // Вызывается из motionPoll() после каждого перемещения
+void motionPoll();                          // Вызывать из loop()
+uint16_t motionHalfPeriod(uint16_t speed, uint16_t iter, uint16_t k);  // Полупериод шага k, мкс
+bool motionPending();                       // Есть сообщения о завершении для motionPoll()
+const MotionStats &motionStats();
+
+#endif
@@ -0,0 +1,97 @@
+#include "prof.h"
+
+#if PROFILE
+
+#include <string.h>
+
+#include "framer.h"
+
+static_assert(PROF_FRAME_HEAD + PROF_BUCKETS * 2 <= MAX_PAYLOAD_SIZE, "Profile entry does not fit one frame");
+
+static ProfEntry table[PROF_REGION_COUNT];
+
+// Ответ на 0x07, кадр за проход loop()
+static bool sending = false;
+static uint8_t nextRegion = 0;
+static uint8_t sendFlags = 0;
+
+void profBegin() {
+    halCyclesBegin();
+    profReset();
+}
+
+void profReset() {
+    memset(table, 0, sizeof(table));
+    for (uint8_t r = 0; r < PROF_REGION_COUNT; r++) table[r].min = UINT32_MAX;
+}
+
+void profRecord(ProfRegion region, uint32_t cycles) {
+    ProfEntry &e = table[region];
+    e.count++;
+    e.sum += cycles;
+    if (cycles < e.min) e.min = cycles;
+    if (cycles > e.max) e.max = cycles;
+
+    uint8_t bucket = cycles ? 32 - __builtin_clz(cycles) : 0;
+    if (bucket >= PROF_BUCKETS) bucket = PROF_BUCKETS - 1;
+    if (e.hist[bucket] != 0xFFFF) e.hist[bucket]++;
+}
+
+const ProfEntry &profEntry(ProfRegion region) {
+    return table[region];
+}
+
+static void put32(uint8_t *p, uint32_t v) {
+    p[0] = v;
+    p[1] = v >> 8;
+    p[2] = v >> 16;
+    p[3] = v >> 24;
+}
+
+void profSend(uint8_t flags) {
+    sending = true;
+    nextRegion = 0;
+    sendFlags = flags;
+}
+
+// Кадр на участок, пустые крайние корзины гистограммы пропускаются.
+// Таблица обнуляется после кадра последнего участка
+void profPoll() {
+    if (!sending || framerRoomUs() != 0) return;
+
+    uint8_t r = nextRegion++;
+    const ProfEntry &e = table[r];
+    uint8_t first = PROF_BUCKETS, last = 0;
+    for (uint8_t b = 0; b < PROF_BUCKETS; b++) {
+        if (!e.hist[b]) continue;
+        if (first == PROF_BUCKETS) first = b;
+        last = b + 1;
+    }
+    if (first == PROF_BUCKETS) first = last = 0;
+
+    uint8_t frame[PROF_FRAME_HEAD + PROF_BUCKETS * 2];
+    frame[0] = r;
+    frame[1] = PROF_REGION_COUNT;
+    put32(frame + 2, e.count);
+    put32(frame + 6, e.count ? e.min : 0);
+    put32(frame + 10, e.max);
+    put32(frame + 14, e.count ? (uint32_t)(e.sum / e.count) : 0);
+    frame[18] = first;
+    frame[19] = last - first;
+    uint8_t n = 0;
+    for (uint8_t b = first; b < last; b++, n++) {
+        frame[PROF_FRAME_HEAD + 2 * n] = e.hist[b];
+        frame[PROF_FRAME_HEAD + 2 * n + 1] = e.hist[b] >> 8;
+    }
+    framerSend(PROF_REPLY, frame, PROF_FRAME_HEAD + 2 * n);
+
+    if (nextRegion < PROF_REGION_COUNT) return;
+    sending = false;
+    if (sendFlags & PROF_RESET) profReset();
+}
+
+bool profStreaming() {
+    return sending;
+}
+
+#endif
@@ -0,0 +1,97 @@
+#ifndef prof_h
+#define prof_h
+
+// Профилирование участков кода по счётчику тактов ядра (halCycles()).
+// Для каждого участка в статической таблице копятся число замеров,
+// наименьшее, наибольшее и сумма тактов и гистограмма по степеням двойки:
+// корзина k > 0 — от 2^(k-1) до 2^k - 1 тактов, корзина 0 — ноль тактов.
+// Замер — два чтения счётчика и обновление строки таблицы, десятки тактов,
+// поэтому профилирование можно оставлять в рабочей прошивке.
+// С PROFILE 0 (config.h) макросы пусты и таблица не собирается.
+//
+// Команда 0x07 [| PROF_RESET] выгружает таблицу кадрами 0x87, по кадру на участок:
+// участок (1) | участков (1) | замеров (4) | min (4) | max (4) | среднее (4) |
+// первая корзина (1) | корзин (1) | счётчики корзин по 2 байта.
+// Числа little-endian, такты на CPU_HZ; пустые крайние корзины не передаются.
+// Кадры уходят по одному за проход loop(), когда в очереди передачи есть место.
+
+#include <stdint.h>
+
+#include "config.h"
+#include "hal.h"
+
+#define PROF_COMMAND 0x07
+#define PROF_REPLY 0x87
+#define PROF_RESET 0x01             // Флаг запроса: обнулить таблицу после выгрузки
+
+#define PROF_BUCKETS 32
+#define PROF_FRAME_HEAD 20
+
+// Участки: имя и название для разбора на хосте
+#define PROF_REGIONS(X) \
+    X(PROF_LOOP, "loop") \
+    X(PROF_SCHED_POLL, "schedPoll") \
+    X(PROF_READ_PACKET, "readPacket") \
+    X(PROF_HANDLE_COMMAND, "handleCommand") \
+    X(PROF_BUS_POLL, "busPoll") \
+    X(PROF_GET_TIME, "getTime") \
+    X(PROF_STORE_SAVE, "store checkpoint") \
+    X(PROF_LOG_DRAIN, "logDrain")
+
+enum ProfRegion : uint8_t {
+#define PROF_ENUM(name, text) name,
+    PROF_REGIONS(PROF_ENUM)
+#undef PROF_ENUM
+    PROF_REGION_COUNT
+};
+
+struct ProfEntry {
+    uint32_t count;
+    uint32_t min;
+    uint32_t max;
+    uint64_t sum;
+    uint16_t hist[PROF_BUCKETS];    // Насыщаются на 0xFFFF
+};
+
+#if PROFILE
+
+void profBegin();                                   // Запуск счётчика тактов
+void profRecord(ProfRegion region, uint32_t cycles);
+void profReset();
+const ProfEntry &profEntry(ProfRegion region);
+void profSend(uint8_t flags);                       // Ответ на команду 0x07
+void profPoll();                                    // Вызывать из loop(): очередной кадр ответа
+bool profStreaming();                               // Ответ не закончен
+
+// Замер от создания до выхода из блока
+class ProfScope {
+public:
+    explicit ProfScope(ProfRegion region) : region_(region), start_(halCycles()) {}
+    ~ProfScope() { profRecord(region_, halCycles() - start_); }
+
+private:
+    ProfRegion region_;
+    uint32_t start_;
+};
+
+#define PROF_CONCAT2(a, b) a##b
+#define PROF_CONCAT(a, b) PROF_CONCAT2(a, b)
+#define PROF_SCOPE(region) ProfScope PROF_CONCAT(profScope, __LINE__)(region)
+// Замер, растянутый на несколько проходов loop(): начало запоминается в переменной
+#define PROF_MARK(var) ((var) = halCycles())
+#define PROF_SINCE(region, start) profRecord(region, halCycles() - (start))
+
+#else
+
+inline void profBegin() {}
+inline void profSend(uint8_t) {}
+inline void profPoll() {}
+inline bool profStreaming() { return false; }
+
+#define PROF_SCOPE(region) do {} while (0)
+#define PROF_MARK(var) do {} while (0)
+#define PROF_SINCE(region, start) do {} while (0)
+
+#endif
+
+#endif
@@ -0,0 +1,64 @@
+#ifndef ramp_h
+#define ramp_h
+
+// Таблицы разгона шагового двигателя, вычисляемые при компиляции.
+// Разгон от startHz до topHz шагов/с задан во времени: скорость растёт
+// линейно (трапеция) или по кривой 3x^2 - 2x^3 (S-кривая: ускорение
+// нарастает и спадает плавно, рывок ограничен). Длительность разгона
+// T = (topHz - startHz) / accel — у обеих форм одинаковая и путь одинаковый,
+// accel — среднее ускорение, у S-кривой пиковое в 1.5 раза больше.
+// Для шага n находится момент t_n, когда пройдено n шагов, а в таблицу
+// пишется полупериод STEP (t_{n+1} - t_n) / 2 в мкс. Генератору шагов
+// остаётся одно чтение таблицы на шаг, без деления и корня.
+
+#include <stdint.h>
+
+#define RAMP_TRAPEZOID 0
+#define RAMP_S_CURVE 1
+
+// Пройденный за время t путь, шагов
+constexpr double rampDistance(int shape, double v0, double v1, double T, double t) {
+    return shape == RAMP_S_CURVE
+        ? v0 * t + (v1 - v0) * T * ((t / T) * (t / T) * (t / T) - (t / T) * (t / T) * (t / T) * (t / T) / 2)
+        : v0 * t + (v1 - v0) * t * t / T / 2;
+}
+
+// Скорость в момент t, шагов/с
+constexpr double rampVelocity(int shape, double v0, double v1, double T, double t) {
+    return shape == RAMP_S_CURVE
+        ? v0 + (v1 - v0) * (3 * (t / T) * (t / T) - 2 * (t / T) * (t / T) * (t / T))
+        : v0 + (v1 - v0) * t / T;
+}
+
+// Момент, когда пройдено n шагов: путь монотонен, поиск делением пополам
+constexpr double rampTime(int shape, double v0, double v1, double T, double n) {
+    double lo = 0, hi = T;
+    for (int i = 0; i < 48; i++) {
+        double mid = (lo + hi) / 2;
+        if (rampDistance(shape, v0, v1, T, mid) < n) lo = mid;
+        else hi = mid;
+    }
+    return (lo + hi) / 2;
+}
+
+template <int Shape, uint32_t StartHz, uint32_t TopHz, uint32_t Accel>
+struct RampTable {
+    static_assert(StartHz > 0 && TopHz >= StartHz && Accel > 0, "Bad ramp parameters");
+    static_assert(500000 / StartHz <= 0xFFFF, "Start half-period must fit uint16_t");
+
+    static constexpr double T = double(TopHz - StartHz) / Accel;       // Длительность разгона, с
+    static constexpr uint16_t size = uint16_t((StartHz + TopHz) * T / 2);  // Шагов разгона
+
+    uint16_t half[size > 0 ? size : 1];     // Полупериоды шагов 0 .. size-1, мкс
+
+    constexpr RampTable() : half() {
+        double t0 = 0;
+        for (uint16_t n = 0; n < size; n++) {
+            double t1 = rampTime(Shape, StartHz, TopHz, T, n + 1);
+            half[n] = uint16_t((t1 - t0) * 500000 + 0.5);
+            t0 = t1;
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,47 @@
+#ifndef ring_h
+#define ring_h
+
+// Кольцевой буфер без блокировок на одного писателя и одного читателя:
+// один конец — прерывание, другой — loop() (приём UART: пишет прерывание,
+// передача: читает прерывание). Индексы свободно
+// бегут по uint16_t, поэтому N обязан быть степенью двойки.
+
+#include <stdint.h>
+
+template <uint16_t N>
+class Ring {
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "Ring size must be a power of two");
+
+public:
+    bool push(uint8_t b) {
+        uint16_t head = head_;
+        if ((uint16_t)(head - tail_) >= N) {
+            overflows_++;
+            return false;
+        }
+        buf_[head & (N - 1)] = b;
+        head_ = head + 1;           // Публикация после записи данных
+        return true;
+    }
+
+    bool pop(uint8_t &b) {
+        uint16_t tail = tail_;
+        if (tail == head_) return false;
+        b = buf_[tail & (N - 1)];
+        tail_ = tail + 1;
+        return true;
+    }
+
+    uint16_t size() const { return (uint16_t)(head_ - tail_); }
+    uint16_t room() const { return N - size(); }
+    bool empty() const { return head_ == tail_; }
+    uint32_t overflows() const { return overflows_; }  // Потерянные байты
+
+private:
+    uint8_t buf_[N];
+    volatile uint16_t head_ = 0;
+    volatile uint16_t tail_ = 0;
+    volatile uint32_t overflows_ = 0;
+};
+
+#endif
@@ -0,0 +1,145 @@
+#include "scheduler.h"
+
+#include "calendar.h"
+#include "config.h"
+#include "hal.h"
+#include "prof.h"
+#include "tasks.h"
+#include "time.h"
+
+#define WEEK_SECONDS 604800UL
+
+static int8_t intPin = -1;
+static SchedHandler onDue = nullptr;
+
+static bool dirty = true;           // Нужен пересчёт ближайшего кормления
+static uint32_t lastEpoch = 0;      // Время последней проверки, секунды от 2000 года
+static uint32_t deadline = 0;       // millis() следующей проверки
+static int16_t nextTask = -1;
+static int16_t alarmMinute = -1;    // Минута суток, записанная в Alarm 1
+static SchedStats stats;
+
+// Сколько секунд пройдёт от from до to в пределах недели
+static uint32_t since(uint32_t from, uint32_t to) {
+    return (to + WEEK_SECONDS - from) % WEEK_SECONDS;
+}
+
+// Первое срабатывание после секунды недели sec (по кругу)
+static uint16_t firstAfter(uint32_t sec) {
+    uint16_t k = tasksFind((sec / 60 + 1) % WEEK_MINUTES);
+    return k == tasksIndexSize() ? 0 : k;
+}
+
+// Ближайшее кормление после now — двоичный поиск в индексе — и установка будильника
+static void recompute(uint32_t now) {
+    stats.recomputes++;
+
+    uint32_t best = 0;
+    nextTask = -1;
+    if (tasksIndexSize() > 0) {
+        uint16_t k = firstAfter(now);
+        nextTask = tasksTaskAt(k);
+        best = since(now, tasksMinuteAt(k) * 60UL);
+        if (best == 0) best = WEEK_SECONDS;     // Эта минута уже обработана
+    }
+
+    uint32_t sleepMs = SCHED_MAX_SLEEP_MS;
+    if (nextTask >= 0) {
+        if (intPin >= 0) {
+            // Точное пробуждение по INT, millis() — только страховка.
+            // Будильник ежедневный: в другие дни пробуждение лишь пересчитает расписание
+            TaskEntry e = tasksGet(nextTask);
+            if (taskMinute(e) != alarmMinute) {
+                setAlarm(taskHours(e), taskMinutes(e), 0);
+                alarmMinute = taskMinute(e);
+            }
+        } else if (best * 1000UL < sleepMs) {
+            sleepMs = best * 1000UL;
+        }
+    }
+    deadline = halMillis() + sleepMs;
+}
+
+void schedBegin(int8_t pin, SchedHandler handler) {
+    intPin = pin;
+    onDue = handler;
+    if (intPin >= 0) halPinInputPullup(intPin);
+
+    dirty = true;
+    lastEpoch = 0;
+    alarmMinute = -1;
+}
+
+void schedInvalidate() {
+    dirty = true;
+}
+
+void schedTimeChanged() {
+    dirty = true;
+}
+
+void schedPoll() {
+    bool alarm = schedAlarmPending();
+    if (!dirty && !alarm && (int32_t)(halMillis() - deadline) < 0) return;
+    PROF_SCOPE(PROF_SCHED_POLL);
+
+    stats.wakeups++;
+    if (alarm) {
+        checkAlarm();
+        clockSync();    // Будильник точнее программных часов
+    }
+
+    uint32_t epoch = clockEpoch();
+    uint32_t now = secondOfWeek(epoch);     // 0 — понедельник 00:00:00
+
+    if (dirty) {
+        // Задача на текущую минуту ещё может сработать, но не повторно: окно
+        // начинается с начала минуты или с прошлой проверки, если она позже.
+        // Если часы переведены назад не больше чем на SCHED_HOLD_S (поправка
+        // ухода), прошлая проверка остаётся в будущем: кормления до неё уже
+        // выполнены по старому времени, и окно пустое, пока часы её не догонят
+        uint32_t minuteStart = epoch - epoch % 60 - 1;
+        if (lastEpoch < minuteStart || lastEpoch > epoch + SCHED_HOLD_S) lastEpoch = minuteStart;
+        dirty = false;
+    }
+
+    // Выполняются срабатывания в промежутке (lastEpoch, epoch]: индекс
+    // обходится по кругу от первого после lastSec, пока срабатывания попадают в окно
+    if ((int32_t)(epoch - lastEpoch) > 0) {
+        uint32_t lastSec = secondOfWeek(lastEpoch);
+        uint32_t window = epoch - lastEpoch;
+        uint16_t size = tasksIndexSize();
+        uint16_t k = firstAfter(lastSec);
+        for (uint16_t n = 0; n < size; n++, k = (k + 1) % size) {
+            uint32_t d = since(lastSec, tasksMinuteAt(k) * 60UL);
+            if (d == 0 || d > window) break;
+            stats.fired++;
+            if (onDue) onDue(tasksTaskAt(k));
+        }
+        lastEpoch = epoch;
+    }
+
+    recompute(now);
+}
+
+int16_t schedNextTask() {
+    return nextTask;
+}
+
+uint32_t schedDeadline() {
+    return deadline;
+}
+
+uint32_t schedIdleMs() {
+    if (dirty || schedAlarmPending()) return 0;
+    int32_t left = (int32_t)(deadline - halMillis());
+    return left > 0 ? left : 0;
+}
+
+bool schedAlarmPending() {
+    return intPin >= 0 && !halPinRead(intPin);
+}
+
+const SchedStats &schedStats() {
+    return stats;
+}
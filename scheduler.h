@@ -0,0 +1,33 @@
+#ifndef scheduler_h
+#define scheduler_h
+
+// Планировщик кормлений по ближайшему будильнику.
+// Вместо ежесекундного опроса часов по индексу таблицы задач (tasks.h)
+// находится одно ближайшее кормление: его время записывается в Alarm 1 часов
+// DS3231 (если подключён вывод INT) и в крайний срок по millis(). До
+// срабатывания schedPoll() ничего не делает.
+// Пересчёт нужен только после addTask/removeTask/setTime — schedInvalidate().
+
+#include <stdint.h>
+
+typedef void (*SchedHandler)(uint8_t task);  // Выполнить кормление по задаче task
+
+// Счётчики работы планировщика
+struct SchedStats {
+    uint32_t wakeups;       // Пробуждения с чтением часов
+    uint32_t recomputes;    // Пересчёты ближайшего кормления
+    uint32_t fired;         // Выполненные кормления
+};
+
+void schedBegin(int8_t intPin, SchedHandler handler);  // intPin = -1, если INT не подключён
+void schedInvalidate();     // Изменились задачи
+void schedTimeChanged();    // Изменилось время часов
+void schedPoll();           // Вызывать из loop()
+
+int16_t schedNextTask();            // Ближайшая задача или -1
+uint32_t schedDeadline();           // Значение millis() следующей проверки
+uint32_t schedIdleMs();             // Сколько мс schedPoll() нечего делать; 0 — пора
+bool schedAlarmPending();           // Будильник DS3231 опустил INT
+const SchedStats &schedStats();
+
+#endif
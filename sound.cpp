@@ -0,0 +1,135 @@
+#include "sound.h"
+
+#include "hal.h"
+#include "ring.h"
+
+#define SOUND_SEMITONE 1.0594630943592953   // 2^(1/12)
+#define SOUND_REST_US (SOUND_TICK_MS * 1000UL)
+
+// Полупериоды нот SOUND_NOTE_LOW..SOUND_NOTE_HIGH, мкс
+struct NoteTable {
+    uint16_t half[SOUND_NOTE_HIGH - SOUND_NOTE_LOW + 1];
+
+    constexpr NoteTable() : half() {
+        double hz = 440;
+        for (int n = 69; n > SOUND_NOTE_LOW; n--) hz /= SOUND_SEMITONE;
+        for (int n = SOUND_NOTE_LOW; n <= SOUND_NOTE_HIGH; n++) {
+            half[n - SOUND_NOTE_LOW] = uint16_t(500000 / hz + 0.5);
+            hz *= SOUND_SEMITONE;
+        }
+    }
+};
+
+static constexpr NoteTable notes{};
+static_assert(SOUND_REST < SOUND_NOTE_LOW, "Rest must not be a note");
+static_assert(SOUND_REST_US <= 0xFFFF, "Timers count 16 bits of microseconds");
+
+// Мелодии сигналов, по порядку SoundCue
+static const SoundNote feeding[] = {{84, 8}, {88, 8}, {91, 8}, {96, 16}, {SOUND_REST, 0}};     // C6 E6 G6 C7
+static const SoundNote connected[] = {{91, 5}, {SOUND_REST, 3}, {96, 8}, {SOUND_REST, 0}};      // G6 C7
+static const SoundNote error[] = {{79, 20}, {SOUND_REST, 5}, {72, 35}, {SOUND_REST, 0}};        // G5 C5
+static const SoundNote *const melodies[SOUND_CUES] = {feeding, connected, error};
+
+// Очередь пишет soundPlay(), читает прерывание, а пока таймер стоит — kick()
+static Ring<SOUND_QUEUE> queue;
+static volatile bool running = false;   // Таймер звука запущен
+static const SoundNote *note = nullptr; // Следующая нота текущей мелодии
+static uint16_t left = 0;               // Оставшиеся полупериоды ноты или единицы паузы
+static bool silent = false;             // Текущая нота — пауза
+static bool level = true;               // Уровень на выводе SOUND
+static SoundStats stats;
+
+uint16_t soundHalfPeriod(uint8_t note) {
+    if (note < SOUND_NOTE_LOW) note = SOUND_NOTE_LOW;
+    if (note > SOUND_NOTE_HIGH) note = SOUND_NOTE_HIGH;
+    return notes.half[note - SOUND_NOTE_LOW];
+}
+
+// Следующая нота текущей мелодии, а после её конца — первая нота следующего
+// сигнала из очереди. Возвращает период таймера, 0 — играть нечего
+static uint32_t nextNote() {
+    for (;;) {
+        if (!note || note->ticks == 0) {
+            uint8_t cue;
+            if (!queue.pop(cue)) {
+                note = nullptr;
+                return 0;
+            }
+            note = melodies[cue];
+            stats.cues++;
+            continue;
+        }
+        const SoundNote &n = *note++;
+        stats.notes++;
+        if (n.note == SOUND_REST) {
+            silent = true;
+            left = n.ticks;
+            return SOUND_REST_US;
+        }
+        // Целое число периодов: нота заканчивается на высоком уровне
+        uint16_t half = soundHalfPeriod(n.note);
+        left = (uint32_t)n.ticks * SOUND_TICK_MS * 500 / half * 2;
+        if (left == 0) continue;
+        silent = false;
+        return half;
+    }
+}
+
+static void soundIsr() {
+    stats.interrupts++;
+    if (!silent) {
+        level = !level;
+        halPinWrite(SOUND, level);
+    }
+    if (--left > 0) return;
+
+    uint32_t period = nextNote();
+    if (period == 0) {
+        halTimerStop(HAL_TIMER_SOUND);
+        running = false;
+        return;
+    }
+    halTimerSetPeriod(HAL_TIMER_SOUND, period);
+}
+
+// Таймер стоит — прерывание не читает очередь, и первую ноту можно взять здесь
+static void kick() {
+    if (running) return;
+    uint32_t period = nextNote();
+    if (period == 0) return;
+    running = true;
+    halTimerStart(HAL_TIMER_SOUND, period, soundIsr);
+}
+
+void soundBegin() {
+    if (running) halTimerStop(HAL_TIMER_SOUND);
+    running = false;
+    note = nullptr;
+    uint8_t cue;
+    while (queue.pop(cue)) {}
+
+    halPinOutput(SOUND);
+    level = true;
+    halPinWrite(SOUND, level);  // Высокий уровень — пищалка выключена
+}
+
+bool soundPlay(SoundCue cue) {
+    if (cue >= SOUND_CUES || !queue.push(cue)) {
+        stats.dropped++;
+        return false;
+    }
+    kick();
+    return true;
+}
+
+bool soundBusy() {
+    return running || !queue.empty();
+}
+
+const SoundNote *soundMelody(SoundCue cue) {
+    return melodies[cue < SOUND_CUES ? cue : 0];
+}
+
+const SoundStats &soundStats() {
+    return stats;
+}
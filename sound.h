@@ -0,0 +1,55 @@
+#ifndef sound_h
+#define sound_h
+
+// Неблокирующий звук: короткие мелодии (сигналы) на пищалке SOUND.
+// Мелодия — таблица нот во флеш-памяти, по два байта на ноту. Ноты играет
+// прерывание таймера HAL_TIMER_SOUND: оно переключает вывод каждые полпериода
+// ноты, а в конце ноты берёт следующую из таблицы или следующий сигнал из
+// очереди. loop() только ставит сигнал в очередь, поэтому звук идёт
+// одновременно с двигателями и не задерживает кормление.
+// Полупериоды нот — таблица, вычисляемая при компиляции (равномерная
+// темперация от A4 = 440 Гц), в прерывании остаётся одно деление на ноту.
+// Нота звучит целым числом периодов и заканчивается высоким уровнем
+// (пищалка выключена), поэтому длительность короче заданной меньше чем на период.
+
+#include <stdint.h>
+
+#include "config.h"
+
+#define SOUND_QUEUE 4       // Сигналов в очереди (степень двойки)
+#define SOUND_TICK_MS 10    // Единица длительности ноты, мс
+
+// Ноты по номерам MIDI: 60 — C4, 69 — A4
+#define SOUND_REST 0        // Пауза
+#define SOUND_NOTE_LOW 48   // C3 — самая низкая нота таблицы
+#define SOUND_NOTE_HIGH 107 // B7 — самая высокая
+
+// Нота мелодии; {SOUND_REST, 0} — конец мелодии
+struct SoundNote {
+    uint8_t note;           // Номер MIDI или SOUND_REST
+    uint8_t ticks;          // Длительность, единиц SOUND_TICK_MS
+};
+
+enum SoundCue : uint8_t {
+    SOUND_FEEDING,          // Кормление началось
+    SOUND_CONNECTED,        // Первая команда приложения после паузы
+    SOUND_ERROR,            // Кормление не поставлено, часы сбились
+    SOUND_CUES
+};
+
+// Счётчики звука
+struct SoundStats {
+    uint32_t cues;          // Начатые сигналы
+    uint32_t dropped;       // Не поместились в очередь
+    uint32_t notes;         // Сыгранные ноты и паузы
+    uint32_t interrupts;    // Вызовы прерывания
+};
+
+void soundBegin();
+bool soundPlay(SoundCue cue);                   // false — очередь заполнена
+bool soundBusy();                               // Сигнал звучит или ждёт в очереди
+const SoundNote *soundMelody(SoundCue cue);
+uint16_t soundHalfPeriod(uint8_t note);         // Полупериод ноты, мкс
+const SoundStats &soundStats();
+
+#endif
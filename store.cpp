@@ -0,0 +1,393 @@
+#include "store.h"
+
+#include <string.h>
+
+#include "crc.h"
+#include "eeprom.h"
+#include "log.h"
+#include "prof.h"
+
+// Заголовок образа: 'F' 'D' | версия | CRC-8 | поколение (2) | количество (2),
+// за ним количество записей по 4 байта (little-endian).
+// CRC-8 считается по байтам 4..7 заголовка и по записям
+#define STORE_MAGIC0 'F'
+#define STORE_MAGIC1 'D'
+#define STORE_VERSION 3
+#define STORE_HEADER 8
+
+static_assert(STORE_HEADER + STORE_KEYS * 4 <= STORE_IMAGE_SIZE, "Task table does not fit the image");
+static_assert(STORE_JOURNAL_SIZE % EEPROM_PAGE == 0 && EEPROM_PAGE % STORE_RECORD == 0,
+              "Journal records must not cross EEPROM pages");
+
+// Запись журнала: поколение (2) | номер (2) | ключ (2) | значение (4) |
+// осталось в пачке (1) | номер первой записи пачки (2) | 0xFF (2) | CRC-8.
+// Изменения одного коммита пишутся пачкой подряд идущих записей и при загрузке
+// применяются, только если пачка дописана до конца
+
+static uint32_t table[STORE_KEYS];
+static uint8_t activeImage = 0;         // 0 — STORE_IMAGE_A, 1 — STORE_IMAGE_B
+static uint16_t newest = 0;             // Самое новое поколение в EEPROM, в том числе непрочитанного образа
+static StoreStats stats;
+
+// Изменённые, но ещё не записанные ключи
+static uint8_t dirty[(STORE_KEYS + 7) / 8];
+static uint16_t dirtyCount = 0;
+static bool batching = false;
+
+// Сохранение образа идёт по страницам: следующая страница ставится в очередь
+// шины из обработчика завершения предыдущей, поэтому очередь не переполняется
+static struct {
+    bool active;            // Сохранение идёт
+    bool again;             // Запрошено ещё одно сохранение
+    uint8_t image;
+    uint16_t generation;
+    uint16_t next;          // Смещение следующего байта записей
+    uint8_t crc;
+#if PROFILE
+    uint32_t started;       // Такты в начале сохранения
+#endif
+} ckpt;
+
+// Пачка журнала пишется так же: страница записей за раз, следующая — из
+// обработчика завершения предыдущей. Ключи, изменённые во время записи
+// пачки, снова помечаются изменёнными и уходят следующей пачкой
+static struct {
+    bool active;            // Пачка пишется
+    uint16_t start;         // Номер первой записи пачки
+    uint16_t remaining;     // Записей пачки, ещё не поставленных в очередь
+    uint16_t key;           // С какого ключа искать следующую запись
+} journal;
+static uint8_t pending[(STORE_KEYS + 7) / 8];   // Ключи пачки
+
+// Страница, не поместившаяся в очередь шины: её обработчик повторяет storePoll()
+static BusCallback resume = nullptr;
+
+static uint16_t imageAddr(uint8_t image) {
+    return image ? STORE_IMAGE_B : STORE_IMAGE_A;
+}
+
+static void put16(uint8_t *p, uint16_t v) { p[0] = v; p[1] = v >> 8; }
+static void put32(uint8_t *p, uint32_t v) { put16(p, v); put16(p + 2, v >> 16); }
+static uint16_t get16(const uint8_t *p) { return p[0] | (p[1] << 8); }
+static uint32_t get32(const uint8_t *p) { return get16(p) | ((uint32_t)get16(p + 2) << 16); }
+
+// Поколение 0xFFFF совпадало бы с чистой EEPROM
+static uint16_t nextGeneration(uint16_t g) {
+    return (g + 1 == 0xFFFF) ? 0 : g + 1;
+}
+
+// Поколения сравниваются с учётом переполнения счётчика
+static void seenGeneration(uint16_t g) {
+    if ((int16_t)(g - newest) > 0) newest = g;
+}
+
+// Поколение первой записи журнала: с неё начинает каждое поколение, оставившее записи
+static bool journalGeneration(uint16_t &g) {
+    uint8_t rec[STORE_RECORD];
+    if (!eepromRead(STORE_JOURNAL_ADDR, rec, sizeof(rec))) return false;
+    if (crc8(rec, STORE_RECORD - 1) != rec[STORE_RECORD - 1]) return false;
+    g = get16(rec);
+    return true;
+}
+
+// Запись в EEPROM завершилась: ошибки только считаются, таблица в памяти уже новая
+static void onWritten(uint8_t, bool ok, const uint8_t *, uint8_t) {
+    if (ok) return;
+    stats.errors++;
+    LOG(LOG_STORE_ERROR, stats.errors);
+}
+
+// Заголовок образа; false — образа нет
+static bool readHeader(uint8_t image, uint8_t *header) {
+    if (!eepromRead(imageAddr(image), header, STORE_HEADER)) return false;
+    if (header[0] != STORE_MAGIC0 || header[1] != STORE_MAGIC1 || header[2] != STORE_VERSION) return false;
+    return get16(header + 6) == STORE_KEYS;
+}
+
+// Чтение записей образа одним последовательным проходом прямо в таблицу и проверка CRC
+static bool loadImage(uint8_t image, const uint8_t *header) {
+    if (!eepromReadStart(imageAddr(image) + STORE_HEADER)) return false;
+    uint8_t crc = crc8(header + 4, 4);
+    for (uint16_t off = 0; off < STORE_KEYS * 4; off += EEPROM_PAGE) {
+        uint8_t buf[EEPROM_PAGE];
+        uint16_t n = STORE_KEYS * 4 - off < EEPROM_PAGE ? STORE_KEYS * 4 - off : EEPROM_PAGE;
+        if (!eepromReadNext(buf, n)) return false;
+        crc = crc8(buf, n, crc);
+        for (uint16_t k = 0; k < n; k += 4) table[(off + k) / 4] = get32(buf + k);
+    }
+    return crc == header[3];
+}
+
+static void setDirty(uint16_t key) {
+    if (dirty[key / 8] & (1 << (key % 8))) return;
+    dirty[key / 8] |= 1 << (key % 8);
+    dirtyCount++;
+}
+
+static void clearDirty() {
+    memset(dirty, 0, sizeof(dirty));
+    dirtyCount = 0;
+}
+
+// Применение журнала текущего поколения, чтение подряд до первой чистой записи.
+// Записи пачки копятся и применяются, когда пришла её последняя запись
+static void replayJournal() {
+    uint16_t keys[STORE_JOURNAL_RECORDS];
+    uint32_t values[STORE_JOURNAL_RECORDS];
+    uint16_t batch = STORE_JOURNAL_RECORDS;     // Первая запись открытой пачки
+    uint8_t expect = 0;                         // Ожидаемый остаток следующей записи
+
+    stats.journalUsed = 0;
+    if (!eepromReadStart(STORE_JOURNAL_ADDR)) return;
+    for (uint16_t page = 0; page < STORE_JOURNAL_SIZE; page += EEPROM_PAGE) {
+        uint8_t buf[EEPROM_PAGE];
+        if (!eepromReadNext(buf, EEPROM_PAGE)) return;
+        for (uint16_t off = 0; off < EEPROM_PAGE; off += STORE_RECORD) {
+            const uint8_t *rec = buf + off;
+            uint16_t i = (page + off) / STORE_RECORD;
+            if (crc8(rec, STORE_RECORD - 1) != rec[STORE_RECORD - 1]) return;  // Чистая или недописанная запись
+            if (get16(rec) != stats.generation || get16(rec + 2) != i) return;  // Запись прошлого поколения
+            stats.journalUsed = i + 1;
+
+            keys[i] = get16(rec + 4);
+            values[i] = get32(rec + 6);
+            uint8_t remaining = rec[10];
+            uint16_t start = get16(rec + 11);
+            if (start == i) {
+                batch = i;                      // Новая пачка; недописанная предыдущая отбрасывается
+            } else if (start != batch || remaining != expect) {
+                batch = STORE_JOURNAL_RECORDS;  // Хвост чужой пачки
+                continue;
+            }
+
+            if (remaining > 0) {
+                expect = remaining - 1;
+                continue;
+            }
+            for (uint16_t k = batch; k <= i; k++) {
+                if (keys[k] < STORE_KEYS) table[keys[k]] = values[k];
+            }
+            batch = STORE_JOURNAL_RECORDS;
+        }
+    }
+}
+
+bool storeBegin(const uint32_t *defaults, uint16_t count) {
+    busFlush();                             // Сохранение, начатое до перезапуска
+    ckpt.active = false;
+    ckpt.again = false;
+    journal.active = false;
+    resume = nullptr;
+    batching = false;
+    clearDirty();
+
+    uint8_t headerA[STORE_HEADER], headerB[STORE_HEADER];
+    bool okA = readHeader(0, headerA);
+    bool okB = readHeader(1, headerB);
+
+    // Следующее сохранение получит поколение новее всех, что есть в EEPROM:
+    // иначе записи журнала поколения, чей образ не прочитался, снова стали бы действующими
+    uint16_t g;
+    newest = 0;
+    if (okA) seenGeneration(get16(headerA + 4));
+    if (okB) seenGeneration(get16(headerB + 4));
+    if (journalGeneration(g)) seenGeneration(g);
+
+    // Сначала образ с большим поколением, при ошибке CRC — другой
+    uint8_t first = (okA && (!okB || (int16_t)(get16(headerA + 4) - get16(headerB + 4)) > 0)) ? 0 : 1;
+    for (uint8_t n = 0; n < 2; n++) {
+        uint8_t image = first ^ n;
+        const uint8_t *header = image ? headerB : headerA;
+        if (!(image ? okB : okA) || !loadImage(image, header)) continue;
+        activeImage = image;
+        stats.generation = get16(header + 4);
+        replayJournal();
+        // Образ новее не прочитался: записи старого поколения легли бы в журнал
+        // между записями испорченного, поэтому сразу начинается новое поколение
+        if ((int16_t)(newest - stats.generation) > 0) storeCheckpoint();
+        return true;
+    }
+
+    // Действующего образа нет: значения по умолчанию, журнал начинается заново
+    for (uint16_t k = 0; k < STORE_KEYS; k++) table[k] = k < count ? defaults[k] : 0;
+    activeImage = 1;
+    stats.generation = 0;
+    storeCheckpoint();
+    return false;
+}
+
+uint32_t storeGet(uint16_t key) {
+    return key < STORE_KEYS ? table[key] : 0;
+}
+
+// Запись журнала текущего поколения с номером index
+static void putRecord(uint8_t *rec, uint16_t key, uint16_t index, uint16_t start, uint8_t remaining) {
+    memset(rec, 0xFF, STORE_RECORD);
+    put16(rec, stats.generation);
+    put16(rec + 2, index);
+    put16(rec + 4, key);
+    put32(rec + 6, table[key]);
+    rec[10] = remaining;
+    put16(rec + 11, start);
+    rec[STORE_RECORD - 1] = crc8(rec, STORE_RECORD - 1);
+}
+
+static void commit();
+
+// Следующая страница записей пачки: записи до конца страницы EEPROM
+// ставятся одной записью шины, а не по одной
+static void postJournalPage(uint8_t id, bool ok, const uint8_t *data, uint8_t len) {
+    onWritten(id, ok, data, len);
+    if (journal.remaining == 0) {
+        journal.active = false;
+        // Изменения, пришедшие во время записи пачки
+        if (ckpt.again) storeCheckpoint();
+        else commit();
+        return;
+    }
+
+    uint8_t buf[EEPROM_PAGE];
+    uint8_t n = 0;
+    uint16_t index = stats.journalUsed;
+    uint16_t key = journal.key;
+    uint16_t remaining = journal.remaining;
+    do {
+        while (!(pending[key / 8] & (1 << (key % 8)))) key++;
+        putRecord(buf + n * STORE_RECORD, key++, index++, journal.start, (uint8_t)--remaining);
+        n++;
+    } while (remaining > 0 && index % (EEPROM_PAGE / STORE_RECORD) != 0);
+
+    uint16_t addr = STORE_JOURNAL_ADDR + stats.journalUsed * STORE_RECORD;
+    if (!eepromWriteAsync(addr, buf, n * STORE_RECORD, postJournalPage)) {
+        resume = postJournalPage;
+        return;
+    }
+    journal.key = key;
+    journal.remaining = remaining;
+    stats.journalUsed = index;
+    stats.appends += n;
+}
+
+// Запись изменённых ключей одной пачкой; если журнал не вмещает пачку —
+// новый образ. Во время сохранения образа или записи пачки ключи ждут её окончания
+static void commit() {
+    if (batching || ckpt.active || journal.active || dirtyCount == 0) return;
+    if (stats.journalUsed + dirtyCount > STORE_JOURNAL_RECORDS) {
+        storeCheckpoint();
+        return;
+    }
+
+    memcpy(pending, dirty, sizeof(pending));
+    journal.active = true;
+    journal.start = stats.journalUsed;
+    journal.remaining = dirtyCount;
+    journal.key = 0;
+    clearDirty();
+    stats.commits++;
+    postJournalPage(0, true, nullptr, 0);
+}
+
+// Заголовок записан: образ действует, журнал начинается с нуля
+static void onHeaderWritten(uint8_t id, bool ok, const uint8_t *data, uint8_t len) {
+    onWritten(id, ok, data, len);
+    ckpt.active = false;
+    activeImage = ckpt.image;
+    stats.generation = newest = ckpt.generation;
+    stats.journalUsed = 0;
+    stats.checkpoints++;
+    PROF_SINCE(PROF_STORE_SAVE, ckpt.started);
+
+    // Изменения, пришедшие во время сохранения, идут в журнал нового поколения
+    if (ckpt.again) storeCheckpoint();
+    else commit();
+}
+
+// Следующая страница записей или, после последней, заголовок.
+// Заголовок пишется последним: недописанный образ не пройдёт проверку
+static void postCheckpointPage(uint8_t id, bool ok, const uint8_t *data, uint8_t len) {
+    onWritten(id, ok, data, len);
+    uint16_t addr = imageAddr(ckpt.image);
+
+    if (ckpt.next < STORE_KEYS * 4) {
+        uint16_t at = addr + STORE_HEADER + ckpt.next;
+        uint16_t n = EEPROM_PAGE - at % EEPROM_PAGE;
+        if (n > STORE_KEYS * 4 - ckpt.next) n = STORE_KEYS * 4 - ckpt.next;
+
+        uint8_t buf[EEPROM_PAGE];
+        for (uint16_t k = 0; k < n; k += 4) put32(buf + k, table[(ckpt.next + k) / 4]);
+        if (!eepromWriteAsync(at, buf, n, postCheckpointPage)) {
+            resume = postCheckpointPage;
+            return;
+        }
+        ckpt.crc = crc8(buf, n, ckpt.crc);
+        ckpt.next += n;
+        return;
+    }
+
+    uint8_t header[STORE_HEADER];
+    header[0] = STORE_MAGIC0;
+    header[1] = STORE_MAGIC1;
+    header[2] = STORE_VERSION;
+    header[3] = ckpt.crc;
+    put16(header + 4, ckpt.generation);
+    put16(header + 6, STORE_KEYS);
+    if (!eepromWriteAsync(addr, header, STORE_HEADER, onHeaderWritten)) resume = postCheckpointPage;
+}
+
+void storeCheckpoint() {
+    if (ckpt.active || journal.active) {
+        ckpt.again = true;
+        return;
+    }
+    ckpt.active = true;
+    ckpt.again = false;
+    PROF_MARK(ckpt.started);
+    clearDirty();                           // Все изменения попадут в образ
+    ckpt.image = activeImage ^ 1;
+    ckpt.generation = nextGeneration(newest);
+    ckpt.next = 0;
+
+    uint8_t head[4];
+    put16(head, ckpt.generation);
+    put16(head + 2, STORE_KEYS);
+    ckpt.crc = crc8(head, 4);
+
+    // Записи журнала старого поколения остаются в силе, пока не записан заголовок
+    postCheckpointPage(0, true, nullptr, 0);
+}
+
+bool storeSet(uint16_t key, uint32_t value) {
+    if (key >= STORE_KEYS) return false;
+    if (table[key] == value) {
+        stats.skipped++;
+        return true;
+    }
+    table[key] = value;
+    setDirty(key);
+    commit();
+    return true;
+}
+
+void storeBeginBatch() {
+    batching = true;
+}
+
+void storeEndBatch() {
+    batching = false;
+    commit();
+}
+
+void storePoll() {
+    if (!resume) return;
+    BusCallback cb = resume;
+    resume = nullptr;
+    cb(0, true, nullptr, 0);
+}
+
+bool storeBusy() {
+    return ckpt.active || journal.active;
+}
+
+const StoreStats &storeStats() {
+    return stats;
+}
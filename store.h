@@ -0,0 +1,52 @@
+#ifndef store_h
+#define store_h
+
+// Хранилище таблицы задач в EEPROM: образ с заголовком и журнал изменений.
+// Каждое изменение записи — одна 16-байтная запись журнала с CRC, журнал
+// заполняется по кругу поколений: когда место кончается, вся таблица
+// сохраняется в другую копию образа с номером поколения на единицу больше,
+// а старые записи журнала перестают действовать. Так запись распределяется
+// по всему журналу и двум копиям образа, а не по одним и тем же ячейкам.
+// При загрузке берётся действующий образ и к нему применяется журнал.
+// Загрузка синхронная, а записи ставятся в очередь шины (bus.h):
+// storeSet() возвращается сразу, EEPROM догоняет в следующих проходах loop().
+// Записи журнала и образ ставятся в очередь по странице EEPROM за раз;
+// страницу, не поместившуюся в заполненную очередь, повторяет storePoll().
+
+#include <stdint.h>
+
+#include "config.h"
+
+#define STORE_KEYS (MAX_TASK + 1)                       // Задачи и версия расписания (tasks.h)
+#define STORE_RECORD 16                                 // Размер записи журнала, байт
+#define STORE_JOURNAL_RECORDS (STORE_JOURNAL_SIZE / STORE_RECORD)
+
+// Счётчики хранилища
+struct StoreStats {
+    uint32_t appends;       // Записи в журнал
+    uint32_t commits;       // Пачки записей в журнале
+    uint32_t checkpoints;   // Сохранения образа
+    uint32_t skipped;       // Изменения без записи: значение не изменилось
+    uint32_t errors;        // Записи, не подтверждённые EEPROM
+    uint16_t generation;    // Поколение действующего образа
+    uint16_t journalUsed;   // Записей журнала в текущем поколении
+};
+
+// Загрузка таблицы. Если действующего образа нет, первые count записей
+// берутся из defaults, остальные обнуляются.
+// Возвращает true, если таблица восстановлена из EEPROM
+bool storeBegin(const uint32_t *defaults, uint16_t count);
+
+uint32_t storeGet(uint16_t key);
+bool storeSet(uint16_t key, uint32_t value);   // false — неверный ключ
+
+// Изменения между storeBeginBatch() и storeEndBatch() записываются одним
+// коммитом: при загрузке применяются все или ни одного
+void storeBeginBatch();
+void storeEndBatch();
+void storeCheckpoint();                        // Сохранить образ и начать новое поколение
+void storePoll();                              // Вызывать из loop(): повтор отложенной страницы
+bool storeBusy();                              // Образ или пачка журнала пишется по страницам
+const StoreStats &storeStats();
+
+#endif
@@ -0,0 +1,140 @@
+#include "sync.h"
+
+#include <string.h>
+
+#include "framer.h"
+#include "scheduler.h"
+#include "tasks.h"
+
+static_assert(SYNC_PER_FRAME * (SYNC_PART + 1) >= MAX_TASK, "Task table does not fit one sync");
+static_assert(MAX_TASK <= 256, "Sync records carry an 8-bit task number");
+
+// Загрузка, собираемая по частям
+static TaskEntry staged[MAX_TASK];
+static uint8_t stagedMask[(MAX_TASK + 7) / 8];
+static uint8_t nextPart = 0;        // Ожидаемая часть; 0 — загрузки нет
+static bool broken = false;         // Часть пропущена, загрузка будет отклонена
+static bool invalid = false;        // Неверная запись, загрузка будет отклонена
+
+// Выгрузка, кадр за проход loop()
+static bool downloading = false;
+static bool downFull = false;       // Все занятые задачи, а не изменённые после downSince
+static uint16_t downSince = 0;
+static uint16_t downVersion = 0;    // Версия на момент запроса: правки во время выгрузки новее
+static uint16_t downNext = 0;       // Следующая задача для кадра
+static uint8_t downPart = 0;
+
+static uint16_t get16(const uint8_t *p) { return p[0] | (p[1] << 8); }
+
+static void putRecord(uint8_t *p, uint16_t i, TaskEntry e) {
+    p[0] = (uint8_t)i;
+    p[1] = e;
+    p[2] = e >> 8;
+    p[3] = e >> 16;
+    p[4] = e >> 24;
+}
+
+// Задача попадает в выгрузку
+static bool wanted(uint16_t i) {
+    return downFull ? taskUsed(tasksGet(i)) : tasksChangedSince(i, downSince);
+}
+
+void syncDownload(const Packet &pkt) {
+    downSince = pkt.len >= 2 ? get16(pkt.payload) : 0;
+    downFull = (pkt.len >= 3 && (pkt.payload[2] & SYNC_FULL)) || !tasksKnownSince(downSince);
+    downVersion = tasksVersion();
+    downNext = 0;
+    downPart = 0;
+    downloading = true;
+}
+
+// Кадр выгрузки, когда он помещается в очередь передачи. Правка задачи,
+// уже переданной в этой выгрузке, новее downVersion и придёт со следующей
+void syncPoll() {
+    if (!downloading || framerRoomUs() != 0) return;
+
+    uint8_t frame[MAX_PAYLOAD_SIZE];
+    uint8_t records = 0;
+    for (; downNext < MAX_TASK && records < SYNC_PER_FRAME; downNext++) {
+        if (!wanted(downNext)) continue;
+        putRecord(frame + SYNC_HEADER + records * SYNC_RECORD, downNext, tasksGet(downNext));
+        records++;
+    }
+    // Последний кадр — тот, после которого задач для выгрузки не осталось
+    while (downNext < MAX_TASK && !wanted(downNext)) downNext++;
+    bool last = downNext == MAX_TASK;
+
+    frame[0] = downVersion & 0xFF;
+    frame[1] = downVersion >> 8;
+    frame[2] = (downFull ? SYNC_FULL : 0) | (last ? SYNC_LAST : 0) | downPart++;
+    framerSend(SYNC_DOWNLOAD | SYNC_REPLY, frame, SYNC_HEADER + records * SYNC_RECORD);
+    if (last) downloading = false;
+}
+
+bool syncStreaming() {
+    return downloading;
+}
+
+static void reply(uint8_t status) {
+    uint16_t version = tasksVersion();
+    uint8_t frame[3] = {status, (uint8_t)(version & 0xFF), (uint8_t)(version >> 8)};
+    framerSend(SYNC_UPLOAD | SYNC_REPLY, frame, sizeof(frame));
+}
+
+void syncUpload(const Packet &pkt) {
+    if (pkt.len < SYNC_HEADER) return;
+    uint8_t part = pkt.payload[2];
+
+    if ((part & SYNC_PART) == 0) {
+        memset(stagedMask, 0, sizeof(stagedMask));
+        broken = false;
+        invalid = false;
+    } else if ((part & SYNC_PART) != nextPart) {
+        broken = true;
+    }
+    nextPart = (part & SYNC_PART) + 1;
+
+    for (uint8_t off = SYNC_HEADER; off + SYNC_RECORD <= pkt.len; off += SYNC_RECORD) {
+        const uint8_t *rec = pkt.payload + off;
+        TaskEntry e = (uint32_t)rec[1] | ((uint32_t)rec[2] << 8) |
+                      ((uint32_t)rec[3] << 16) | ((uint32_t)rec[4] << 24);
+#if MAX_TASK < 256
+        if (rec[0] >= MAX_TASK) {
+            invalid = true;
+            continue;
+        }
+#endif
+        if (!taskValid(e)) {
+            invalid = true;
+            continue;
+        }
+        staged[rec[0]] = e;
+        stagedMask[rec[0] / 8] |= 1 << (rec[0] % 8);
+    }
+    if (!(part & SYNC_LAST)) return;
+
+    nextPart = 0;
+    if (broken) {
+        reply(SYNC_SEQUENCE);
+        return;
+    }
+    if (invalid) {
+        reply(SYNC_INVALID);
+        return;
+    }
+    // Изменения поверх устаревшей версии отклоняются: приложение сначала выгружает таблицу
+    bool full = part & SYNC_FULL;
+    if (!full && get16(pkt.payload) != tasksVersion()) {
+        reply(SYNC_CONFLICT);
+        return;
+    }
+
+    tasksBeginBatch();
+    for (uint16_t i = 0; i < MAX_TASK; i++) {
+        if (stagedMask[i / 8] & (1 << (i % 8))) tasksSet(i, staged[i]);
+        else if (full) tasksSet(i, TASK_FREE);
+    }
+    tasksEndBatch();
+    schedInvalidate();
+    reply(SYNC_OK);
+}
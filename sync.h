@@ -0,0 +1,48 @@
+#ifndef sync_h
+#define sync_h
+
+// Синхронизация расписания с приложением одним обменом.
+// Таблица передаётся кадрами (framer.h) по SYNC_PER_FRAME записей.
+// Данные кадра: версия (2, little-endian) | часть | записи по 5 байт:
+// номер задачи и упакованная задача (tasks.h, 4 байта little-endian).
+// Байт части: биты 0..5 — номер части, SYNC_FULL — вся таблица,
+// SYNC_LAST — последняя часть.
+//
+// 0x05 — выгрузка: запрос «версия приложения (2) [| SYNC_FULL]».
+//   Ответ — кадры 0x85 с версией на момент запроса: все занятые задачи (SYNC_FULL)
+//   или задачи, изменённые после версии приложения; свободная запись — удаление.
+//   Кадры уходят по одному за проход loop(), когда в очереди передачи есть место.
+// 0x06 — загрузка: кадры с версией, на которой основаны изменения.
+//   Части копятся и применяются после последней одним коммитом хранилища;
+//   с SYNC_FULL задачи, которых нет в загрузке, удаляются. Если хоть одна
+//   запись неверна (tasks.h), загрузка отклоняется целиком.
+//   Ответ — кадр 0x86: статус (1) | версия после применения (2).
+
+#include <stdint.h>
+
+#include "main.h"
+
+#define SYNC_DOWNLOAD 0x05
+#define SYNC_UPLOAD 0x06
+#define SYNC_REPLY 0x80             // Ответ: команда | SYNC_REPLY
+
+#define SYNC_HEADER 3
+#define SYNC_RECORD 5
+#define SYNC_PER_FRAME ((MAX_PAYLOAD_SIZE - SYNC_HEADER) / SYNC_RECORD)
+
+#define SYNC_PART 0x3F
+#define SYNC_FULL 0x40
+#define SYNC_LAST 0x80
+
+// Статус загрузки
+#define SYNC_OK 0
+#define SYNC_CONFLICT 1             // Расписание изменилось после версии приложения
+#define SYNC_SEQUENCE 2             // Пропущена часть
+#define SYNC_INVALID 3              // Неверная задача или номер: не применено ничего
+
+void syncDownload(const Packet &pkt);       // Команда 0x05
+void syncPoll();                            // Вызывать из loop(): очередной кадр выгрузки
+bool syncStreaming();                       // Выгрузка не закончена
+void syncUpload(const Packet &pkt);
+
+#endif
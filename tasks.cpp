@@ -0,0 +1,178 @@
+#include "tasks.h"
+
+#include <string.h>
+
+#include "store.h"
+
+static_assert(MAX_TASK <= 256, "Task number must fit uint8_t");
+static_assert(MAX_TASK <= STORE_KEYS, "Task table does not fit the store");
+static_assert((uint32_t)PARTITION * TASK_MAX_PORTIONS <= 0xFFFF, "Portions must fit one motion move");
+
+// Индекс: минута недели и номер задачи, по возрастанию минуты, затем номера.
+// Два массива вместо массива структур — без выравнивания, 3 байта на срабатывание
+static uint16_t indexMinute[TASK_INDEX];
+static uint8_t indexTask[TASK_INDEX];
+static uint16_t indexSize = 0;
+static uint16_t used = 0;
+
+static uint16_t version = 0;            // Версия расписания
+static uint16_t bootVersion = 0;        // Версия при запуске
+static uint16_t changedAt[MAX_TASK];    // Версия последнего изменения задачи
+static bool batching = false;
+static bool batchChanged = false;
+
+// a новее b с учётом переполнения счётчика
+static bool newer(uint16_t a, uint16_t b) {
+    return (int16_t)(a - b) > 0;
+}
+
+// Позиция первого срабатывания, не меньшего (minute, task)
+static uint16_t lowerBound(uint16_t minute, uint8_t task) {
+    uint16_t lo = 0, hi = indexSize;
+    while (lo < hi) {
+        uint16_t mid = (lo + hi) / 2;
+        if (indexMinute[mid] < minute || (indexMinute[mid] == minute && indexTask[mid] < task)) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+static void removeFromIndex(uint8_t task) {
+    uint16_t n = 0;
+    for (uint16_t k = 0; k < indexSize; k++) {
+        if (indexTask[k] == task) continue;
+        indexMinute[n] = indexMinute[k];
+        indexTask[n] = indexTask[k];
+        n++;
+    }
+    indexSize = n;
+}
+
+static void insertIntoIndex(uint8_t task, TaskEntry e) {
+    for (uint8_t day = 0; day < 7; day++) {
+        if (!(taskDays(e) & (1 << day))) continue;
+        uint16_t minute = day * 1440 + taskMinute(e);
+        uint16_t k = lowerBound(minute, task);
+        memmove(indexMinute + k + 1, indexMinute + k, (indexSize - k) * sizeof(indexMinute[0]));
+        memmove(indexTask + k + 1, indexTask + k, (indexSize - k) * sizeof(indexTask[0]));
+        indexMinute[k] = minute;
+        indexTask[k] = task;
+        indexSize++;
+    }
+}
+
+// Задачи сортируются по минуте суток, и индекс заполняется день за днём
+static void rebuildIndex() {
+    uint8_t order[MAX_TASK];
+    used = 0;
+    for (uint16_t i = 0; i < MAX_TASK; i++) {
+        TaskEntry e = tasksGet(i);
+        if (!taskUsed(e)) continue;
+        uint16_t k = used++;
+        while (k > 0 && taskMinute(tasksGet(order[k - 1])) > taskMinute(e)) {
+            order[k] = order[k - 1];
+            k--;
+        }
+        order[k] = i;
+    }
+
+    indexSize = 0;
+    for (uint8_t day = 0; day < 7; day++) {
+        for (uint16_t k = 0; k < used; k++) {
+            TaskEntry e = tasksGet(order[k]);
+            if (!(taskDays(e) & (1 << day))) continue;
+            indexMinute[indexSize] = day * 1440 + taskMinute(e);
+            indexTask[indexSize] = order[k];
+            indexSize++;
+        }
+    }
+}
+
+void tasksBegin() {
+    batching = false;
+    version = bootVersion = (uint16_t)storeGet(TASK_VERSION_KEY);
+    for (uint16_t i = 0; i < MAX_TASK; i++) changedAt[i] = version;
+    rebuildIndex();
+}
+
+TaskEntry tasksGet(uint16_t i) {
+    return i < MAX_TASK ? storeGet(i) : TASK_FREE;
+}
+
+bool tasksSet(uint16_t i, TaskEntry e) {
+    if (i >= MAX_TASK) return false;
+    if (!taskUsed(e)) e = TASK_FREE;
+
+    TaskEntry old = tasksGet(i);
+    if (old == e) return true;
+
+    bool single = !batching;
+    if (single) tasksBeginBatch();
+    storeSet(i, e);
+    changedAt[i] = version + 1;
+    batchChanged = true;
+    if (single) {
+        // Одна задача: индекс правится на месте, без полной перестройки
+        if (taskUsed(old)) {
+            removeFromIndex(i);
+            used--;
+        }
+        if (taskUsed(e)) {
+            insertIntoIndex(i, e);
+            used++;
+        }
+        batching = false;
+        version++;
+        storeSet(TASK_VERSION_KEY, version);
+        storeEndBatch();
+    }
+    return true;
+}
+
+void tasksBeginBatch() {
+    batching = true;
+    batchChanged = false;
+    storeBeginBatch();
+}
+
+void tasksEndBatch() {
+    batching = false;
+    if (batchChanged) {
+        version++;
+        storeSet(TASK_VERSION_KEY, version);
+        rebuildIndex();
+    }
+    storeEndBatch();
+}
+
+uint16_t tasksVersion() {
+    return version;
+}
+
+bool tasksKnownSince(uint16_t v) {
+    return !newer(bootVersion, v) && !newer(v, version);
+}
+
+bool tasksChangedSince(uint16_t i, uint16_t v) {
+    return i < MAX_TASK && newer(changedAt[i], v);
+}
+
+uint16_t tasksUsed() {
+    return used;
+}
+
+uint16_t tasksIndexSize() {
+    return indexSize;
+}
+
+uint16_t tasksFind(uint16_t minuteOfWeek) {
+    return lowerBound(minuteOfWeek, 0);
+}
+
+uint16_t tasksMinuteAt(uint16_t k) {
+    return indexMinute[k];
+}
+
+uint8_t tasksTaskAt(uint16_t k) {
+    return indexTask[k];
+}
@@ -0,0 +1,79 @@
+#ifndef tasks_h
+#define tasks_h
+
+// Таблица задач кормления.
+// Задача упакована в 32 бита и хранится прямо в хранилище (store.h):
+//   биты 0..10  — минута суток (0..1439)
+//   биты 11..17 — дни недели, бит 11 — понедельник; 0 — запись свободна
+//   биты 18..21 — количество порций по PARTITION шагов (1..15)
+//   биты 22..24 — канал двигателя (motion.h), 0 — шнек
+//   биты 25..31 — резерв, 0
+// Для поиска ближайшего кормления по таблице строится индекс: все
+// срабатывания задач за неделю, отсортированные по минуте недели.
+// Поиск в индексе — двоичный, изменение задачи — сдвиг части индекса.
+// Версия расписания растёт на единицу с каждым коммитом изменений и хранится
+// в хранилище рядом с задачами. Для каждой задачи помнится версия её последнего
+// изменения, поэтому можно выдать только изменённое после данной версии.
+// Что менялось до запуска, неизвестно: такие запросы получают всю таблицу.
+
+#include <stdint.h>
+
+#include "config.h"
+
+#define WEEK_MINUTES 10080
+#define TASK_INDEX (MAX_TASK * 7)   // Срабатываний за неделю в худшем случае
+
+#define TASK_FREE 0
+#define TASK_EVERY_DAY 0x7F
+#define TASK_MAX_PORTIONS 15
+#define TASK_VERSION_KEY MAX_TASK   // Ключ хранилища с версией расписания
+
+typedef uint32_t TaskEntry;
+
+// Упаковка задачи; неверное время даёт свободную запись
+inline TaskEntry taskMake(uint8_t hours, uint8_t minutes, uint8_t days = TASK_EVERY_DAY, uint8_t portions = 1,
+                          uint8_t channel = 0) {
+    if (hours > 23 || minutes > 59 || portions == 0) return TASK_FREE;
+    if (portions > TASK_MAX_PORTIONS) portions = TASK_MAX_PORTIONS;
+    return (uint32_t)(hours * 60 + minutes) | ((uint32_t)(days & 0x7F) << 11) | ((uint32_t)portions << 18) |
+           ((uint32_t)(channel & 0x07) << 22);
+}
+
+inline uint16_t taskMinute(TaskEntry e) { return e & 0x7FF; }
+inline uint8_t taskHours(TaskEntry e) { return taskMinute(e) / 60; }
+inline uint8_t taskMinutes(TaskEntry e) { return taskMinute(e) % 60; }
+inline uint8_t taskDays(TaskEntry e) { return (e >> 11) & 0x7F; }
+inline uint8_t taskPortions(TaskEntry e) { return (e >> 18) & 0x0F; }
+inline uint8_t taskChannel(TaskEntry e) { return (e >> 22) & 0x07; }
+inline bool taskUsed(TaskEntry e) { return taskDays(e) != 0; }
+
+// Задача из приложения: поля разбираются и упаковываются заново через taskMake(),
+// поэтому запись с минутой за пределами суток, без порций, с каналом без
+// двигателя или с битами резерва не совпадёт с упакованной и будет отклонена
+inline bool taskValid(TaskEntry e) {
+    if (e == TASK_FREE) return true;
+    if (!taskUsed(e) || taskMinute(e) >= 24 * 60 || taskChannel(e) >= MOTION_CHANNELS) return false;
+    return taskMake(taskHours(e), taskMinutes(e), taskDays(e), taskPortions(e), taskChannel(e)) == e;
+}
+
+void tasksBegin();                          // Построить индекс по хранилищу
+TaskEntry tasksGet(uint16_t i);
+bool tasksSet(uint16_t i, TaskEntry e);     // Изменить задачу, сохранить её и обновить индекс
+uint16_t tasksUsed();                       // Занятые записи
+
+// Изменения между tasksBeginBatch() и tasksEndBatch() — одна версия,
+// один коммит хранилища и одна перестройка индекса
+void tasksBeginBatch();
+void tasksEndBatch();
+
+uint16_t tasksVersion();
+bool tasksKnownSince(uint16_t version);     // Изменения после version известны по задачам
+bool tasksChangedSince(uint16_t i, uint16_t version);
+
+// Индекс срабатываний
+uint16_t tasksIndexSize();
+uint16_t tasksFind(uint16_t minuteOfWeek);  // Первое срабатывание не раньше minuteOfWeek
+uint16_t tasksMinuteAt(uint16_t k);         // Минута недели, 0 — понедельник 00:00
+uint8_t tasksTaskAt(uint16_t k);            // Номер задачи
+
+#endif
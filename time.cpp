@@ -1,60 +1,59 @@
 #include "time.h"
 
+#include "Arduino.h"
+#include "bcd.h"
+#include "bus.h"
+#include "calendar.h"
+#include "config.h"
+#include "hal.h"
+#include "prof.h"
+
 const uint8_t _addr = 0x68;
-uint8_t _unpackRegister(uint8_t data);
-uint8_t _encodeRegister(int8_t data);
-static uint8_t DS_dim(uint8_t i);
-static uint16_t getWeekDay(uint16_t y, uint8_t m, uint8_t d);
 uint8_t _readRegister(uint8_t addr);
-uint8_t _unpackHours(uint8_t data);
-
-uint8_t _unpackRegister(uint8_t data) {
-    return ((data >> 4) * 10 + (data & 0xF));
-}
+bool _readRegisters(uint8_t addr, uint8_t *buf, uint8_t len);
+void _writeRegisters(const uint8_t *frame, uint8_t len);
 
-uint8_t _encodeRegister(int8_t data) {
-    return (((data / 10) << 4) | (data % 10));
-}
-
-static uint8_t DS_dim(uint8_t i) {
-    return (i < 7) ? ((i == 1) ? 28 : ((i & 1) ? 30 : 31)) : ((i & 1) ? 31 : 30);
-}
+static bool clockValid = false;     // Программные часы сверены с DS3231
+static uint32_t clockBase = 0;      // Время часов DS3231 при сверке
+static uint32_t clockSyncMs = 0;    // millis(), соответствующее началу секунды clockBase
+static uint32_t clockInterval = CLOCK_SYNC_MS;
+static bool syncPending = false;    // Фоновая сверка стоит в очереди шины
+static uint8_t syncJob = 0;
 
-static uint16_t getWeekDay(uint16_t y, uint8_t m, uint8_t d) {
-    if (y >= 2000)
-    y -= 2000;
-    uint16_t days = d;
-    for (uint8_t i = 1; i < m; ++i)
-    //days += pgm_read_byte(_ds_daysInMonth + i - 1);
-    days += DS_dim(i - 1);
-    if (m > 2 && y % 4 == 0) days++;
-    return (days + 365 * y + (y + 3) / 4 + 4) % 7 + 1;
+// Синхронное чтение идёт после всех записей, уже стоящих в очереди шины
+uint8_t _readRegister(uint8_t addr) {
+    busFlush();
+    if (halI2cWrite(_addr, &addr, 1) != 0) return 0;
+    uint8_t data = 0;
+    halI2cRead(_addr, &data, 1);
+    return data;
 }
 
-uint8_t _readRegister(uint8_t addr) {
-    Wire.beginTransmission(_addr);
-    Wire.write(addr);
-    if (Wire.endTransmission() != 0) return 0;
-    Wire.requestFrom(_addr, (uint8_t)1);
-    return Wire.read();
+// Чтение подряд идущих регистров одной транзакцией
+bool _readRegisters(uint8_t addr, uint8_t *buf, uint8_t len) {
+    busFlush();
+    if (halI2cWrite(_addr, &addr, 1) != 0) return false;
+    return halI2cRead(_addr, buf, len) == len;
 }
 
-uint8_t _unpackHours(uint8_t data) {
-    if (data & 0x20) return ((data & 0xF) + 20);
-    else if (data & 0x10) return ((data & 0xF) + 10);
-    else return (data & 0xF);
+// Запись регистров через очередь шины. Установка часов теряться не должна:
+// если очередь заполнена, сначала выполняется то, что в ней стоит
+void _writeRegisters(const uint8_t *frame, uint8_t len) {
+    if (busWrite(_addr, frame, len) != BUS_FULL) return;
+    busFlush();
+    busWrite(_addr, frame, len);
 }
 
 uint8_t getSeconds(void) {
-    return (_unpackRegister(_readRegister(0x00)));
+    return (bcdDecode(_readRegister(0x00)));
 }
 
 uint8_t getMinutes(void) {
-    return (_unpackRegister(_readRegister(0x01)));
+    return (bcdDecode(_readRegister(0x01)));
 }
 
 uint8_t getHours(void) {
-    return (_unpackHours(_readRegister(0x02)));
+    return (bcdDecodeHours(_readRegister(0x02)));
 }
 
 uint8_t getDay(void) {
@@ -62,48 +61,185 @@ uint8_t getDay(void) {
 }
 
 uint8_t getDate(void) {
-    return (_unpackRegister(_readRegister(0x04)));
+    return (bcdDecode(_readRegister(0x04)));
 }
 
 uint8_t getMonth(void) {
-    return (_unpackRegister(_readRegister(0x05)));
+    return (bcdDecode(_readRegister(0x05) & 0x1F));
 }
 
 uint16_t getYear(void) {
-    return (_unpackRegister(_readRegister(0x06)) + 2000);
+    return (bcdDecode(_readRegister(0x06)) + 2000);
 }
 
 void setTime(int8_t seconds, int8_t minutes, int8_t hours, int8_t date, int8_t month, int16_t year) {
     // защиты от дурака
+    year = constrain(year, 2000, 2099);
     month = constrain(month, 1, 12);
-    //date = constrain(date, 0, pgm_read_byte(_ds_daysInMonth + month - 1));
-    date = constrain(date, 0, DS_dim(month - 1));
+    date = constrain(date, 1, daysInMonth(year, month));
     seconds = constrain(seconds, 0, 59);
     minutes = constrain(minutes, 0, 59);
     hours = constrain(hours, 0, 23);
     
-    // отправляем
-    uint8_t day = getWeekDay(year, month, date);
-    year -= 2000;
-    Wire.beginTransmission(_addr);
-    Wire.write(0x00);
-    Wire.write(_encodeRegister(seconds));
-    Wire.write(_encodeRegister(minutes));
-    if (hours > 19) Wire.write((0x2 << 4) | (hours % 20));
-    else if (hours > 9) Wire.write((0x1 << 4) | (hours % 10));
-    else Wire.write(hours);	
-    Wire.write(day);
-    Wire.write(_encodeRegister(date));
-    Wire.write(_encodeRegister(month));
-    Wire.write(_encodeRegister(year));
-    Wire.endTransmission();
-}
-
-Time getTime(void) {
-    return Time{
-        .hours=getHours(),
-        .minutes=getMinutes()
+    // отправляем; часы — в 24-часовом режиме
+    uint8_t frame[8];
+    frame[0] = 0x00;
+    frame[1] = bcdEncode(seconds);
+    frame[2] = bcdEncode(minutes);
+    frame[3] = bcdEncode(hours);
+    frame[4] = weekdayFromDays(daysFromCivil(year, month, date));
+    frame[5] = bcdEncode(date);
+    frame[6] = bcdEncode(month);
+    frame[7] = bcdEncode(year - 2000);
+    _writeRegisters(frame, sizeof(frame));
+    // OSF сбрасывается записью 0; единицы в A2F и A1F флаги не меняют, поэтому
+    // сработавший будильник не теряется. Вывод 32kHz на плате не используется
+    uint8_t status[2] = {0x0F, 0x03};
+    _writeRegisters(status, sizeof(status));
+    clockValid = false;     // Программные часы сверятся при следующем чтении
+    syncPending = false;    // Поставленная раньше сверка прочитает старое время
+}
+
+bool getTime(Time &t) {
+    PROF_SCOPE(PROF_GET_TIME);
+    uint8_t data[3];
+    if (!_readRegisters(0x00, data, sizeof(data))) return false;
+    t = Time{
+        .hours=bcdDecodeHours(data[2]),
+        .minutes=bcdDecode(data[1])
     };
+    return true;
+}
+
+static DateTime unpackDateTime(const uint8_t *data) {
+    return DateTime{
+        .seconds=bcdDecode(data[0]),
+        .minutes=bcdDecode(data[1]),
+        .hours=bcdDecodeHours(data[2]),
+        .day=data[3],
+        .date=bcdDecode(data[4]),
+        .month=bcdDecode(data[5] & 0x1F),
+        .year=(uint16_t)(bcdDecode(data[6]) + 2000)
+    };
+}
+
+bool getDateTime(DateTime &dt) {
+    uint8_t data[7];
+    if (!_readRegisters(0x00, data, sizeof(data))) return false;
+    dt = unpackDateTime(data);
+    return true;
+}
+
+uint32_t toEpoch(const DateTime &dt) {
+    return epochFromCivil(dt.year, dt.month, dt.date, dt.hours, dt.minutes, dt.seconds);
+}
+
+DateTime fromEpoch(uint32_t epoch) {
+    int32_t days = (int32_t)(epoch / 86400UL);
+    uint32_t sec = epoch % 86400UL;
+    CivilDate d = civilFromDays(days);
+    return DateTime{
+        .seconds=(uint8_t)(sec % 60),
+        .minutes=(uint8_t)(sec / 60 % 60),
+        .hours=(uint8_t)(sec / 3600),
+        .day=weekdayFromDays(days),
+        .date=d.day,
+        .month=d.month,
+        .year=(uint16_t)d.year
+    };
+}
+
+// Сверка программных часов с показанием DS3231, прочитанным в момент ms
+static void applySync(uint32_t ms, uint32_t rtc) {
+    uint32_t predicted = clockBase + (ms - clockSyncMs) / 1000;
+    if (!clockValid || predicted > rtc + 2 || rtc > predicted + 2) {
+        clockBase = rtc;
+        clockSyncMs = ms;
+        clockValid = true;
+        return;
+    }
+
+    // Подстройка фазы: millis() начала секунды сдвигается так, чтобы
+    // экстраполяция совпала с показанием DS3231
+    if (predicted < rtc) {
+        clockSyncMs = ms - (rtc - clockBase) * 1000UL;              // Секунда началась только что
+    } else if (predicted > rtc) {
+        clockSyncMs = ms - (rtc - clockBase) * 1000UL - 999;        // Секунда вот-вот закончится
+    }
+    // Основание держится близко к текущему моменту, чтобы не переполнить разность millis()
+    uint32_t whole = (ms - clockSyncMs) / 1000;
+    clockBase += whole;
+    clockSyncMs += whole * 1000UL;
+}
+
+void clockBegin(void) {
+    clockValid = false;
+    syncPending = false;    // Очередь шины после сброса пуста
+}
+
+// Часы не ответили — программные часы идут дальше без сверки
+bool clockSync(void) {
+    uint32_t ms = halMillis();
+    DateTime dt;
+    if (!getDateTime(dt)) return false;
+    applySync(ms, toEpoch(dt));
+    return true;
+}
+
+static void onSyncRead(uint8_t id, bool ok, const uint8_t *data, uint8_t len) {
+    if (!syncPending || id != syncJob) return;
+    syncPending = false;
+    if (ok && len == 7) applySync(halMillis(), toEpoch(unpackDateTime(data)));
+}
+
+void clockSetSyncInterval(uint32_t ms) {
+    clockInterval = ms;
+}
+
+uint32_t clockEpoch(void) {
+    if (!clockValid) {
+        clockSync();
+    } else if (!syncPending && halMillis() - clockSyncMs >= clockInterval) {
+        // Плановая сверка идёт в фоне, до неё время экстраполируется дальше
+        uint8_t reg = 0x00;
+        syncJob = busRead(_addr, &reg, 1, 7, false, onSyncRead);
+        syncPending = syncJob != BUS_FULL;      // Очередь заполнена — попробуем в следующий раз
+    }
+    return clockBase + (halMillis() - clockSyncMs) / 1000;
+}
+
+DateTime clockNow(void) {
+    return fromEpoch(clockEpoch());
+}
+
+uint32_t clockDaySeconds(void) {
+    return clockEpoch() % 86400UL;
+}
+
+void setAlarm(uint8_t hours, uint8_t minutes, uint8_t seconds) {
+    uint8_t frame[9];
+    frame[0] = 0x07;
+    frame[1] = bcdEncode(seconds);
+    frame[2] = bcdEncode(minutes);
+    frame[3] = bcdEncode(hours);
+    frame[4] = 0x80;    // A1M4: совпадение часов, минут и секунд
+    frame[5] = 0x80;    // Alarm 2 не используется
+    frame[6] = 0x80;
+    frame[7] = 0x80;
+    frame[8] = 0x05;    // INTCN | A1IE
+    _writeRegisters(frame, sizeof(frame));
+}
+
+bool checkAlarm(void) {
+    uint8_t status = _readRegister(0x0F);
+    if (!(status & 0x01)) return false;
+    uint8_t frame[2] = {0x0F, (uint8_t)(status & ~0x01)};  // OSF не трогаем
+    _writeRegisters(frame, sizeof(frame));
+    return true;
+}
+
+bool clockLost(void) {
+    return _readRegister(0x0F) & 0x80;
 }
 
 bool equalTime(Time t1, Time t2){
@@ -1,13 +1,47 @@
-#include "Wire.h"
+#ifndef time_h
+#define time_h
+
+#include <stdint.h>
 
 typedef struct {
     uint8_t hours;
     uint8_t minutes;
 } Time;
 
-Time getTime(void);
+// Полная дата и время часов DS3231
+typedef struct {
+    uint8_t seconds;
+    uint8_t minutes;
+    uint8_t hours;
+    uint8_t day;        // День недели, 1 — понедельник
+    uint8_t date;
+    uint8_t month;
+    uint16_t year;
+} DateTime;
+
+bool getTime(Time &t);          // Одно чтение 0x00..0x02; false — нет ответа
+bool getDateTime(DateTime &dt); // Одно чтение 0x00..0x06: без разрыва на смене минуты или часа; false — нет ответа
 bool equalTime(Time t1, Time t2);
 
+// Секунды от 2000-01-01 00:00:00 (годы 2000..2099)
+uint32_t toEpoch(const DateTime &dt);
+DateTime fromEpoch(uint32_t epoch);
+
+// Программные часы: время экстраполируется по millis() и сверяется с DS3231
+// не чаще раза в CLOCK_SYNC_MS, поэтому чтение времени обычно не занимает шину.
+// Погрешность — меньше секунды плюс уход millis() за интервал сверки.
+// Плановая сверка читает DS3231 через очередь шины (bus.h) и применяется в busPoll()
+void clockBegin(void);          // После сброса: сверка при первом чтении
+bool clockSync(void);           // Немедленная сверка с DS3231; false — часы не ответили
+void clockSetSyncInterval(uint32_t ms);
+uint32_t clockEpoch(void);
+DateTime clockNow(void);
+uint32_t clockDaySeconds(void);
+
+// Alarm 1: срабатывает раз в сутки в hours:minutes:seconds и опускает вывод INT
+void setAlarm(uint8_t hours, uint8_t minutes, uint8_t seconds);
+bool checkAlarm(void);          // true, если будильник сработал; флаг A1F сбрасывается
+
 
 uint8_t getSeconds(void);
 uint8_t getMinutes(void);
@@ -17,4 +51,10 @@ uint8_t getDate(void);
 uint8_t getMonth(void);
 uint16_t getYear(void);
 
-void setTime(int8_t seconds, int8_t minutes, int8_t hours, int8_t date, int8_t month, int16_t year);
\ No newline at end of file
+// Установка времени DS3231; сбрасывает флаг OSF
+void setTime(int8_t seconds, int8_t minutes, int8_t hours, int8_t date, int8_t month, int16_t year);
+// Флаг OSF: генератор DS3231 останавливался (первое включение, села батарея),
+// время в часах неверное, пока его не установят заново
+bool clockLost(void);
+
+#endif
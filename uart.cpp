@@ -0,0 +1,89 @@
+#include "uart.h"
+
+#include "hal.h"
+#include "ring.h"
+
+static Ring<UART_TX_SIZE> tx;
+static volatile bool pumping = false;   // Таймер подкачки запущен: очередь читает прерывание
+static uint32_t byteUs = 10000000UL / BLE_BAUD_FALLBACK;
+static UartStats stats;
+
+// Долить FIFO передатчика из очереди
+static void fill() {
+    uint8_t b;
+    while (halUartTxReady() && tx.pop(b)) halUartTxPut(b);
+}
+
+static void refillIsr() {
+    stats.refills++;
+    fill();
+    if (tx.empty()) {
+        halTimerStop(HAL_TIMER_UART);
+        pumping = false;
+    }
+}
+
+// Таймер стоит — прерывание не читает очередь, и её можно читать здесь
+static void kick() {
+    if (pumping) return;
+    fill();
+    if (tx.empty()) return;
+    pumping = true;
+    halTimerStart(HAL_TIMER_UART, UART_TX_REFILL * byteUs, refillIsr);
+}
+
+void uartBegin(uint32_t baud) {
+    uartFlush();
+    byteUs = 10000000UL / baud;
+    halUartBegin(baud);
+}
+
+// Поставить в очередь сколько поместится
+static size_t put(const uint8_t *data, size_t len) {
+    size_t n = len < uartFree() ? len : uartFree();
+    for (size_t i = 0; i < n; i++) tx.push(data[i]);
+    kick();
+
+    stats.bytes += n;
+    uint16_t queued = tx.size();
+    if (queued > stats.maxQueued) stats.maxQueued = queued;
+    return n;
+}
+
+size_t uartWrite(const uint8_t *data, size_t len) {
+    size_t n = put(data, len);
+    stats.refused += len - n;
+    return n;
+}
+
+void uartWriteAll(const uint8_t *data, size_t len) {
+    size_t n = put(data, len);
+    if (n == len) return;
+    stats.waits++;
+    while (n < len) {
+        // Место в очереди освобождает прерывание подкачки, оно же будит ядро
+        halSleepUs(UART_TX_REFILL * byteUs);
+        n += put(data + n, len - n);
+    }
+}
+
+size_t uartFree() {
+    return UART_TX_SIZE - tx.size();
+}
+
+bool uartBusy() {
+    return !tx.empty() || !halUartTxDone();
+}
+
+void uartFlush() {
+    while (!tx.empty()) halSleepUs(UART_TX_REFILL * byteUs);
+    while (!halUartTxDone()) halSleepUs(byteUs);
+}
+
+uint32_t uartByteUs() {
+    return byteUs;
+}
+
+const UartStats &uartStats() {
+    return stats;
+}
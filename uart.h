@@ -0,0 +1,37 @@
+#ifndef uart_h
+#define uart_h
+
+// Передача по UART модуля BLE без ожидания.
+// Байты кладутся в кольцевую очередь, а FIFO передатчика подкачивает
+// прерывание таймера HAL_TIMER_UART: раз в UART_TX_REFILL байт линии оно
+// доливает FIFO до 16 байт и останавливается, когда очередь пуста.
+// Прерывание самого UART занято ядром Arduino под приём, поэтому таймер
+// заменяет прерывание «FIFO передатчика опустел». Пока таймер стоит,
+// очередь читает только вызывающий, так что у кольца всегда один читатель.
+// uartWrite() не ждёт: принимает столько, сколько помещается, и возвращает
+// это число — заполненная очередь видна вызывающему.
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "config.h"
+
+// Счётчики передачи
+struct UartStats {
+    uint32_t bytes;         // Принятые в очередь байты
+    uint32_t refused;       // Байты, не поместившиеся в очередь
+    uint32_t waits;         // Вызовы uartWriteAll(), ждавшие места
+    uint32_t refills;       // Прерывания подкачки FIFO
+    uint16_t maxQueued;     // Наибольшее заполнение очереди
+};
+
+void uartBegin(uint32_t baud);                          // Дождаться передачи и сменить скорость
+size_t uartWrite(const uint8_t *data, size_t len);      // Без ожидания; вернёт принятое число байт
+void uartWriteAll(const uint8_t *data, size_t len);     // Ждёт места, только если очередь заполнена
+size_t uartFree();                                      // Свободно в очереди, байт
+bool uartBusy();                                        // Очередь или FIFO передатчика не пусты
+void uartFlush();                                       // Дождаться ухода последнего байта в линию
+uint32_t uartByteUs();                                  // Передача одного байта, мкс
+const UartStats &uartStats();
+
+#endif